@@ -0,0 +1,310 @@
+#include "analysis_cache.h"
+#include "parallel.h"
+
+static constexpr char CACHE_MAGIC[8] = { 'L', 'I', 'N', 'I', 'A', 'N', 'A', 0 };
+
+struct CacheFileHeader {
+	char magic[8];
+	uint32_t format;
+	uint32_t class_count;
+	uint32_t method_count;
+	uint32_t strings_size;
+	ProcessInfo::ExeInfo::VersionInfo version;
+};
+
+//format 2 and later, follows the header
+struct CacheFileHierarchy {
+	uint32_t node_count;
+	uint32_t edge_count;
+};
+
+struct CacheFileClass {
+	uint32_t name_offset;
+	uint32_t func_count;
+	uint32_t vtable_offset;
+	uint32_t first_method;
+	uint64_t fingerprint;
+};
+
+static uint64_t fnv1a(uint64_t h, uint8_t b) {
+	return (h ^ b) * 1099511628211ULL;
+}
+
+extern uint64_t method_fingerprint(uint32_t rva) {
+	return method_fingerprint(GameProcessInfo, rva);
+}
+
+extern uint64_t method_fingerprint(const ProcessInfo& p, uint32_t rva) {
+	const auto& text = p.exe.text;
+	if ((rva < text.offset) || (rva >= text.offset + text.size)) return 0;
+
+	auto len = text.offset + text.size - rva;
+	if (len > METHOD_FINGERPRINT_BYTES) len = METHOD_FINGERPRINT_BYTES;
+	const auto code = (const uint8_t*)p.buffer + rva;
+
+	uint64_t h = 14695981039346656037ULL;
+	for (uint32_t i = 0; i < len; ++i) {
+		const auto b = code[i];
+		h = fnv1a(h, b);
+
+		//rel32 of call/jmp moves whenever the target moves
+		if ((b == 0xE8) || (b == 0xE9)) {
+			i += 4;
+			continue;
+		}
+
+		//ret or int3 padding ends the method, the bytes after it belong to a different function
+		if ((b == 0xCC) || ((b == 0xC3) && (i + 1 < len) && (code[i + 1] == 0xCC))) break;
+	}
+	return h;
+}
+
+static void capture_classes(AnalysisCache& cache, const ProcessInfo& p);
+
+extern void analysis_capture(AnalysisCache& cache) {
+	if (class_hierarchy().names.empty()) class_hierarchy_build();
+	cache.hierarchy = class_hierarchy();
+	capture_classes(cache, GameProcessInfo);
+}
+
+extern void analysis_capture(AnalysisCache& cache, const ProcessInfo& p) {
+	class_hierarchy_build(p, cache.hierarchy);
+	capture_classes(cache, p);
+}
+
+static void capture_classes(AnalysisCache& cache, const ProcessInfo& p) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	cache.version = p.exe.version;
+	cache.classes.clear();
+	cache.method_rva.clear();
+	cache.method_hash.clear();
+
+	cache.classes.reserve(p.rtti_map.size());
+	for (const auto& x : p.rtti_map) {
+		CacheClass c{};
+		c.name = x.first;
+		c.func_count = x.second.func_count;
+		c.vtable_offset = x.second.vtable_offset;
+		cache.classes.push_back(std::move(c));
+	}
+	std::sort(cache.classes.begin(), cache.classes.end(), [](const CacheClass& a, const CacheClass& b) { return a.vtable_offset < b.vtable_offset; });
+
+	for (auto& c : cache.classes) {
+		c.first_method = (uint32_t)cache.method_rva.size();
+		const auto methods = (const uintptr_t*)((const char*)p.buffer + c.vtable_offset);
+		for (uint32_t i = 0; i < c.func_count; ++i) {
+			cache.method_rva.push_back((uint32_t)(methods[i] - p.base_address));
+		}
+	}
+
+	//base class methods show up in many vtables, hash each body once
+	std::vector<uint32_t> unique_rva = cache.method_rva;
+	std::sort(unique_rva.begin(), unique_rva.end());
+	unique_rva.erase(std::unique(unique_rva.begin(), unique_rva.end()), unique_rva.end());
+
+	std::vector<uint64_t> unique_hash(unique_rva.size());
+	parallel_chunks(unique_rva.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) unique_hash[i] = method_fingerprint(p, unique_rva[i]);
+	});
+
+	cache.method_hash.resize(cache.method_rva.size());
+	parallel_chunks(cache.classes.size(), [&](size_t begin, size_t end) {
+		for (size_t k = begin; k < end; ++k) {
+			auto& c = cache.classes[k];
+			uint64_t h = 14695981039346656037ULL;
+			for (uint32_t i = 0; i < c.func_count; ++i) {
+				const auto m = c.first_method + i;
+				const auto found = std::lower_bound(unique_rva.begin(), unique_rva.end(), cache.method_rva[m]);
+				cache.method_hash[m] = unique_hash[found - unique_rva.begin()];
+				h = (h ^ cache.method_hash[m]) * 1099511628211ULL;
+			}
+			c.fingerprint = h;
+		}
+	});
+
+	QueryPerformanceCounter(&end);
+	Log("Analysis cache: %u classes, %u methods (%u unique) hashed in %.2fms",
+		(unsigned)cache.classes.size(),
+		(unsigned)cache.method_rva.size(),
+		(unsigned)unique_rva.size(),
+		(double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart);
+}
+
+extern std::string analysis_cache_path(const ProcessInfo::ExeInfo::VersionInfo& v) {
+	char path[MAX_PATH];
+	snprintf(path, sizeof(path), "analysis_cache/%u.%u.%u.%u.bin", v.major, v.minor, v.build, v.revision);
+	return std::string{ path };
+}
+
+extern bool analysis_cache_save(const AnalysisCache& cache, const char* path) {
+	CreateDirectoryA("analysis_cache", NULL);
+
+	std::string strings;
+	std::vector<CacheFileClass> classes(cache.classes.size());
+	for (size_t i = 0; i < classes.size(); ++i) {
+		const auto& c = cache.classes[i];
+		classes[i] = CacheFileClass{ (uint32_t)strings.size(), c.func_count, c.vtable_offset, c.first_method, c.fingerprint };
+		strings.append(c.name);
+		strings.push_back('\0');
+	}
+
+	const auto& h = cache.hierarchy;
+	std::vector<uint32_t> node_names(h.names.size());
+	for (size_t i = 0; i < node_names.size(); ++i) {
+		node_names[i] = (uint32_t)strings.size();
+		strings.append(h.names[i]);
+		strings.push_back('\0');
+	}
+	const CacheFileHierarchy hier{ (uint32_t)h.names.size(), (uint32_t)h.base_ids.size() };
+
+	CacheFileHeader hdr{};
+	memcpy(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic));
+	hdr.format = ANALYSIS_CACHE_FORMAT;
+	hdr.class_count = (uint32_t)classes.size();
+	hdr.method_count = (uint32_t)cache.method_rva.size();
+	hdr.strings_size = (uint32_t)strings.size();
+	hdr.version = cache.version;
+
+	//assemble the file in memory and write it once
+	std::vector<uint8_t> out;
+	const auto append = [&out](const void* data, size_t size) {
+		out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+	};
+	append(&hdr, sizeof(hdr));
+	append(&hier, sizeof(hier));
+	append(classes.data(), classes.size() * sizeof(CacheFileClass));
+	append(cache.method_hash.data(), cache.method_hash.size() * sizeof(uint64_t));
+	append(cache.method_rva.data(), cache.method_rva.size() * sizeof(uint32_t));
+	if (hier.node_count) append(h.base_begin.data(), h.base_begin.size() * sizeof(uint32_t));
+	append(h.base_ids.data(), h.base_ids.size() * sizeof(uint32_t));
+	append(node_names.data(), node_names.size() * sizeof(uint32_t));
+	append(strings.data(), strings.size());
+
+	FILE* f = NULL;
+	fopen_s(&f, path, "wb");
+	if (!f) {
+		Log("Could not open %s for writing", path);
+		return false;
+	}
+	const auto written = fwrite(out.data(), 1, out.size(), f);
+	fclose(f);
+	return (written == out.size());
+}
+
+extern bool analysis_cache_load(AnalysisCache& cache, const char* path) {
+	FILE* f = NULL;
+	fopen_s(&f, path, "rb");
+	if (!f) {
+		Log("Could not open %s", path);
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+	_fseeki64(f, 0, SEEK_END);
+	data.resize((size_t)_ftelli64(f));
+	_fseeki64(f, 0, SEEK_SET);
+	const auto read = fread(data.data(), 1, data.size(), f);
+	fclose(f);
+
+	CacheFileHeader hdr;
+	if ((read != data.size()) || (data.size() < sizeof(hdr))) {
+		Log("Could not read %s", path);
+		return false;
+	}
+	memcpy(&hdr, data.data(), sizeof(hdr));
+	if (memcmp(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic)) || (hdr.format < 1) || (hdr.format > ANALYSIS_CACHE_FORMAT)) {
+		Log("%s is not a supported analysis cache", path);
+		return false;
+	}
+
+	CacheFileHierarchy hier{};
+	uint64_t hier_size = 0;
+	if (hdr.format >= 2) {
+		if (data.size() < sizeof(hdr) + sizeof(hier)) {
+			Log("%s is corrupt", path);
+			return false;
+		}
+		memcpy(&hier, data.data() + sizeof(hdr), sizeof(hier));
+		hier_size = sizeof(hier) + ((hier.node_count ? (uint64_t)hier.node_count + 1 : 0) + hier.edge_count + hier.node_count) * sizeof(uint32_t);
+	}
+
+	const uint64_t expected = sizeof(hdr)
+		+ (uint64_t)hdr.class_count * sizeof(CacheFileClass)
+		+ (uint64_t)hdr.method_count * (sizeof(uint32_t) + sizeof(uint64_t))
+		+ hier_size
+		+ hdr.strings_size;
+	if ((expected != data.size()) || !hdr.strings_size || data.back()) {
+		Log("%s is corrupt", path);
+		return false;
+	}
+
+	const auto classes = (const CacheFileClass*)(data.data() + sizeof(hdr) + ((hdr.format >= 2) ? sizeof(hier) : 0));
+	const auto hash = (const uint64_t*)(classes + hdr.class_count);
+	const auto rva = (const uint32_t*)(hash + hdr.method_count);
+	const auto base_begin = rva + hdr.method_count;
+	const auto base_ids = base_begin + (hier.node_count ? hier.node_count + 1 : 0);
+	const auto node_names = base_ids + hier.edge_count;
+	const auto strings = (const char*)(node_names + hier.node_count);
+
+	auto& h = cache.hierarchy;
+	h = ClassHierarchy{};
+	if (hier.node_count) {
+		bool ok = (base_begin[0] == 0) && (base_begin[hier.node_count] == hier.edge_count);
+		for (uint32_t i = 0; ok && (i < hier.node_count); ++i) ok = (base_begin[i] <= base_begin[i + 1]) && (node_names[i] < hdr.strings_size);
+		for (uint32_t i = 0; ok && (i < hier.edge_count); ++i) ok = (base_ids[i] < hier.node_count);
+		if (!ok) {
+			Log("%s is corrupt", path);
+			return false;
+		}
+
+		h.base_begin.assign(base_begin, base_begin + hier.node_count + 1);
+		h.base_ids.assign(base_ids, base_ids + hier.edge_count);
+		h.names.reserve(hier.node_count);
+		for (uint32_t i = 0; i < hier.node_count; ++i) h.names.emplace_back(strings + node_names[i]);
+		hierarchy_link_derived(h);
+	}
+
+	cache.version = hdr.version;
+	cache.method_rva.assign(rva, rva + hdr.method_count);
+	cache.method_hash.assign(hash, hash + hdr.method_count);
+	cache.classes.resize(hdr.class_count);
+	for (uint32_t i = 0; i < hdr.class_count; ++i) {
+		const auto& c = classes[i];
+		if ((c.name_offset >= hdr.strings_size) || ((uint64_t)c.first_method + c.func_count > hdr.method_count)) {
+			Log("%s is corrupt", path);
+			cache.classes.clear();
+			return false;
+		}
+		cache.classes[i] = CacheClass{ std::string{ strings + c.name_offset }, c.func_count, c.vtable_offset, c.first_method, c.fingerprint };
+	}
+
+	return true;
+}
+
+extern bool analysis_cache_install_hierarchy(void) {
+	const auto& v = GameProcessInfo.exe.version;
+	const auto path = analysis_cache_path(v);
+	if (GetFileAttributesA(path.c_str()) == INVALID_FILE_ATTRIBUTES) return false;
+
+	AnalysisCache cache;
+	if (!analysis_cache_load(cache, path.c_str()) || cache.hierarchy.names.empty()) return false;
+
+	//the same version can still have been analyzed differently, the vtables must be the same set
+	const auto& cv = cache.version;
+	if ((cv.major != v.major) || (cv.minor != v.minor) || (cv.build != v.build) || (cv.revision != v.revision)) return false;
+	if (cache.classes.size() != GameProcessInfo.rtti_map.size()) return false;
+	std::vector<uint32_t> vtables;
+	vtables.reserve(GameProcessInfo.rtti_map.size());
+	for (const auto& x : GameProcessInfo.rtti_map) vtables.push_back(x.second.vtable_offset);
+	std::sort(vtables.begin(), vtables.end());
+	for (size_t i = 0; i < vtables.size(); ++i) {
+		if (cache.classes[i].vtable_offset != vtables[i]) return false;
+	}
+
+	Log("Class hierarchy: %u classes from %s", (unsigned)cache.hierarchy.names.size(), path.c_str());
+	class_hierarchy_install(std::move(cache.hierarchy));
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "main.h"
+#include "class_hierarchy.h"
+
+//per game version record of the discovered classes and a fingerprint of every vtable method
+//saved to analysis_cache/<version>.bin so later builds can be correlated against it
+
+constexpr uint32_t ANALYSIS_CACHE_FORMAT = 2; //format 1 files (no hierarchy) still load
+constexpr uint32_t METHOD_FINGERPRINT_BYTES = 32; //bytes of each method body that are hashed
+
+struct CacheClass {
+	std::string name;
+	uint32_t func_count;
+	uint32_t vtable_offset;
+	uint32_t first_method;  //index into method_rva/method_hash
+	uint64_t fingerprint;   //hash of all method fingerprints in vtable order
+};
+
+struct AnalysisCache {
+	ProcessInfo::ExeInfo::VersionInfo version;
+	std::vector<CacheClass> classes;   //sorted by vtable_offset
+	std::vector<uint32_t> method_rva;  //vtable slots of all classes
+	std::vector<uint64_t> method_hash;
+	ClassHierarchy hierarchy;
+};
+
+//build the cache from the current rtti_map, method bodies are hashed on all cores
+extern void analysis_capture(AnalysisCache& cache);
+//same for an image other than GameProcessInfo, the hierarchy is built for it as well
+extern void analysis_capture(AnalysisCache& cache, const ProcessInfo& p);
+
+extern std::string analysis_cache_path(const ProcessInfo::ExeInfo::VersionInfo& v);
+extern bool analysis_cache_save(const AnalysisCache& cache, const char* path);
+extern bool analysis_cache_load(AnalysisCache& cache, const char* path);
+//install the class hierarchy saved for this game version if its classes match the current rtti_map
+//returns false if there is no usable cache, the hierarchy then has to be built
+extern bool analysis_cache_install_hierarchy(void);
+
+//fingerprint of the start of a method, call/jmp displacements and everything after the end of the method are ignored
+extern uint64_t method_fingerprint(uint32_t rva);
+extern uint64_t method_fingerprint(const ProcessInfo& p, uint32_t rva);
\ No newline at end of file
@@ -1,42 +1,79 @@
 #include "main.h"
 #include "aob_window.h"
 #include "aobscan.h"
+#include "text_index.h"
+#include "insn_map.h"
+#include "memory_scan.h"
+#include "image_sections.h"
 
 void draw_aob_window() {
-        static char buffer[256];
+        static char buffer[AOB_MAX_SIGNATURE * 3];
+        static char target[32];
         static std::vector<uint32_t> results;
+        static AobSignatureInfo generated{};
+        static double search_ms = 0;
+        static bool instruction_starts = true;
 
 
         if (!GameProcessInfo.rtti_map.size()) {
                 ImGui::Text("Press Scan Starfield in the log window");
                 return;
         }
+        image_text_require();
+
+        ImGui::InputText("Offset", target, sizeof(target), ImGuiInputTextFlags_CharsHexadecimal);
+        ImGui::SameLine();
+        if (ImGui::Button("Generate")) {
+                if (aob_generate((unsigned)strtoul(target, NULL, 16), &generated)) {
+                        snprintf(buffer, sizeof(buffer), "%s", generated.signature.c_str());
+                }
+                else {
+                        generated = AobSignatureInfo{};
+                }
+        }
+        if (generated.length) {
+                ImGui::Text("%u bytes (%u wildcards) over %u instructions, %u initial candidates, %.2fms",
+                        generated.length, generated.wildcards, generated.instructions, generated.initial_candidates, generated.elapsed_ms);
+        }
 
         //TODO: input text filter for hex chars + '?' + ' '
-        ImGui::InputText("Signature", buffer, 256);
+        ImGui::InputText("Signature", buffer, sizeof(buffer));
         ImGui::SameLine();
         if (ImGui::Button("Search")) {
+                LARGE_INTEGER freq, start, end;
+                QueryPerformanceFrequency(&freq);
+                QueryPerformanceCounter(&start);
                 results.clear();
 
                 AOB_SIG sig = aob_compile(buffer);
-                if (sig) {
-                        const auto buff = GameProcessInfo.buffer;
+                if (sig && !text_index_find(sig, results)) {
                         const auto text = GameProcessInfo.exe.text;
-                        unsigned offset = text.offset;
-
-                        do {
-                                offset = aob_scan(buff, text.offset + text.size, offset, sig);
-                                if (offset == AOB_NO_MATCH) break;
-
-                                results.push_back(offset);
-                                ++offset;
-                        } while (true);
-
-                        free(sig);
+                        aob_scan_all(GameProcessInfo.buffer, text.offset, text.offset + text.size, sig, results);
                 }
+                if (sig) free(sig);
+                if (instruction_starts && insn_map_ready()) insn_map_filter(results);
+
+                QueryPerformanceCounter(&end);
+                search_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
         }
 
-        ImGui::Text("%u results", results.size());
+        char index_status[96] = "not built";
+        const auto index = text_index_stats();
+        if (index.state == TextIndex_Building) snprintf(index_status, sizeof(index_status), "building");
+        if (index.state == TextIndex_Failed) snprintf(index_status, sizeof(index_status), "failed");
+        if (index.state == TextIndex_Ready) {
+                snprintf(index_status, sizeof(index_status), "%s in %.0fms, %.1fMB", index.from_cache ? "loaded" : "built",
+                        index.build_ms, (double)index.memory / (1024.0 * 1024.0));
+        }
+        ImGui::Text("%u results in %.2fms | Index: %s", results.size(), search_ms, index_status);
+        if (insn_map_ready()) {
+                ImGui::SameLine();
+                ImGui::Checkbox("Instruction starts only", &instruction_starts);
+        }
+        else if (insn_map_building()) {
+                ImGui::SameLine();
+                ImGui::TextUnformatted("| Instruction map: building");
+        }
 
         ImGui::BeginChild("aob_search_results");
 
@@ -45,8 +82,15 @@ void draw_aob_window() {
         while (clip.Step())
         {
                 for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
-                        char name[64];
-                        snprintf(name, sizeof(name), "starfield.exe+%x (%p)", results[i], (void*)(GameProcessInfo.base_address + results[i]));
+                        char name[96];
+                        FunctionInfo fn;
+                        if (find_function(results[i], &fn)) {
+                                snprintf(name, sizeof(name), "starfield.exe+%x (%p) in starfield.exe+%x+0x%x", results[i],
+                                        (void*)(GameProcessInfo.base_address + results[i]), fn.entry, results[i] - fn.entry);
+                        }
+                        else {
+                                snprintf(name, sizeof(name), "starfield.exe+%x (%p)", results[i], (void*)(GameProcessInfo.base_address + results[i]));
+                        }
                         ImGui::PushID(i);
                         ImGui::InputText("Offset", name, sizeof(name), ImGuiInputTextFlags_ReadOnly);
                         ImGui::PopID();
@@ -1,8 +1,12 @@
 #include "main.h"
 #include "aobscan.h"
+#include "x86_decode.h"
+#include "text_index.h"
+#include "scan_kernels.h"
+#include "task_pool.h"
 
 
-static constexpr uint16_t sig_end = 0xFFFF;
+static constexpr uint16_t sig_end = AOB_SIG_END;
 
 extern AOB_SIG aob_compile(const char* signature) {
         const auto siglen = strlen(signature);
@@ -81,19 +85,158 @@ extern unsigned aob_scan(const void* buffer, unsigned buffer_size, unsigned star
 
         const unsigned char* haystack = (const unsigned char*)buffer + starting_offset;
         const unsigned count = buffer_size - starting_offset;
-        
+
+        //jump between candidates for the first byte, a wildcard first byte is a candidate everywhere
+        const auto find_masked_byte = scan_kernels().find_masked_byte;
+        const uint8_t first_mask = (uint8_t)(sig[0] >> 8);
+        const uint8_t first_value = (uint8_t)(sig[0] & 0xFF);
 
         for (unsigned i = 0; i < count; ++i) {
-                auto match = 0;
+                if (first_mask) {
+                        i += (unsigned)find_masked_byte(haystack + i, count - i, first_value, first_mask);
+                        if (i >= count) break;
+                }
+
+                unsigned match = 0;
 
-                while ((haystack[i] & (sig[match] >> 8)) == (sig[match] & 0xFF)) {
-                        ++i;
+                while (((i + match) < count) && ((haystack[i + match] & (sig[match] >> 8)) == (sig[match] & 0xFF))) {
                         ++match;
                         if (sig[match] == sig_end) {
-                                return starting_offset + (i - match);
+                                return starting_offset + i;
                         }
                 }
         }
 
         return AOB_NO_MATCH;
+}
+
+
+extern void aob_scan_all(const void* buffer, unsigned begin, unsigned end, AOB_SIG sig, std::vector<uint32_t>& results) {
+        results.clear();
+        if (begin >= end) return;
+
+        //a chunk may read the signature length past its end, but only reports matches that start inside it
+        unsigned length = 0;
+        while (sig[length] != sig_end) ++length;
+
+        const size_t count = end - begin;
+        const auto grain = parallel_grain(count, 1 << 20);
+        std::vector<std::vector<uint32_t>> parts((count + grain - 1) / grain);
+        parallel_for(count, grain, [&](size_t first, size_t last) {
+                auto& part = parts[first / grain];
+                const auto chunk_end = begin + (unsigned)last;
+                const auto limit = (unsigned)std::min<uint64_t>((uint64_t)chunk_end + length - 1, end);
+                unsigned offset = begin + (unsigned)first;
+                while ((offset = aob_scan(buffer, limit, offset, sig)) != AOB_NO_MATCH) {
+                        if (offset >= chunk_end) break;
+                        part.push_back(offset);
+                        ++offset;
+                }
+        }, TaskPriority_High);
+
+        for (const auto& part : parts) results.insert(results.end(), part.begin(), part.end());
+}
+
+
+extern bool aob_generate(unsigned offset, AobSignatureInfo* info) {
+        LARGE_INTEGER freq, start, end;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&start);
+
+        *info = AobSignatureInfo{};
+
+        const auto buffer = (const uint8_t*)GameProcessInfo.buffer;
+        const auto text_begin = GameProcessInfo.exe.text.offset;
+        const auto text_end = text_begin + GameProcessInfo.exe.text.size;
+        if ((offset < text_begin) || (offset >= text_end)) {
+                Log("aob_generate: %X is not in .text", offset);
+                return false;
+        }
+
+        uint8_t bytes[AOB_MAX_SIGNATURE];
+        bool wild[AOB_MAX_SIGNATURE];
+        unsigned size = 0;
+        std::vector<unsigned> insn_start;
+
+        //decode whole instructions until at least count bytes are known
+        const auto extend = [&](unsigned count) -> bool {
+                while (size < count) {
+                        X86Insn insn;
+                        if (!x86_decode(buffer + offset + size, text_end - (offset + size), &insn)) {
+                                Log("aob_generate: could not decode the instruction at %X", offset + size);
+                                return false;
+                        }
+
+                        for (unsigned i = 0; (i < insn.length) && (size + i < AOB_MAX_SIGNATURE); ++i) {
+                                const bool in_disp = insn.rip_relative && (i >= insn.disp_offset) && (i < insn.disp_offset + insn.disp_size);
+                                const bool in_imm = (i >= insn.imm_offset) && (i < insn.imm_offset + insn.imm_size) && insn.imm_offset &&
+                                        ((insn.branch && (insn.imm_size == 4)) || (insn.imm_size == 8));
+                                bytes[size + i] = buffer[offset + size + i];
+                                wild[size + i] = in_disp || in_imm;
+                        }
+                        insn_start.push_back(size);
+                        size += insn.length;
+                        if (size > AOB_MAX_SIGNATURE) size = AOB_MAX_SIGNATURE;
+                        if (size == AOB_MAX_SIGNATURE) break;
+                }
+                return true;
+        };
+
+        //the first byte of an instruction is never a wildcard, the second one is for short rip relative forms
+        if (!extend(2)) return false;
+
+        //the suffix array gives the candidates directly once it is built
+        std::vector<unsigned> candidates;
+        if (!text_index_find_exact(bytes, wild[1] ? 1 : 2, candidates)) {
+                for (auto p = buffer + text_begin; ; ++p) {
+                        p = (const uint8_t*)memchr(p, bytes[0], (buffer + text_end - 1) - p);
+                        if (!p) break;
+                        if (wild[1] || (p[1] == bytes[1])) candidates.push_back((unsigned)(p - buffer));
+                }
+        }
+        info->initial_candidates = (unsigned)candidates.size();
+
+        //narrow one byte at a time, the first length that leaves only the target is the shortest signature
+        unsigned length = 2;
+        while (candidates.size() > 1) {
+                if (length >= AOB_MAX_SIGNATURE) {
+                        Log("aob_generate: no unique signature within %u bytes", AOB_MAX_SIGNATURE);
+                        return false;
+                }
+                if (!extend(length + 1)) return false;
+                if (length >= size) {
+                        Log("aob_generate: reached the end of .text");
+                        return false;
+                }
+
+                const auto b = bytes[length];
+                const bool w = wild[length];
+                auto out = candidates.begin();
+                for (const auto c : candidates) {
+                        if (c + length >= text_end) continue;
+                        if (!w && (buffer[c + length] != b)) continue;
+                        *out++ = c;
+                }
+                candidates.erase(out, candidates.end());
+                ++length;
+        }
+
+        char hex[4];
+        for (unsigned i = 0; i < length; ++i) {
+                if (wild[i]) {
+                        info->signature += "??";
+                        ++info->wildcards;
+                }
+                else {
+                        snprintf(hex, sizeof(hex), "%02X", bytes[i]);
+                        info->signature += hex;
+                }
+                if (i + 1 < length) info->signature += ' ';
+        }
+        info->length = length;
+        for (const auto i : insn_start) info->instructions += (i < length);
+
+        QueryPerformanceCounter(&end);
+        info->elapsed_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+        return true;
 }
\ No newline at end of file
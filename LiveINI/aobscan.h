@@ -1,10 +1,15 @@
 #pragma once
 
 constexpr unsigned AOB_NO_MATCH = 0xFFFFFFFF;
+constexpr unsigned AOB_MAX_SIGNATURE = 256; //longest signature aob_generate will try
 
 //treat as opaque
 typedef uint16_t* AOB_SIG;
 
+//compiled signatures are (mask << 8 | value) per byte, terminated by this
+//value bits are never set outside the mask, so it can not collide with a literal byte
+constexpr uint16_t AOB_SIG_END = 0x00FF;
+
 //compiles an array of bytes string to an optimized format, returns null on error
 extern AOB_SIG aob_compile(const char* signature);
 
@@ -14,3 +19,21 @@ extern void aob_free(AOB_SIG sig);
 /// scan a buffer of memory for a hex signature match, ?? is supported
 /// returns the offset of the match or AOB_NO_MATCH
 extern unsigned aob_scan(const void* buffer, unsigned buffer_size, unsigned starting_offset, AOB_SIG sig);
+
+/// every match starting in [begin, end) of a buffer, in ascending order, scanned in parallel on the task pool
+extern void aob_scan_all(const void* buffer, unsigned begin, unsigned end, AOB_SIG sig, std::vector<uint32_t>& results);
+
+
+struct AobSignatureInfo {
+        std::string signature;       //aob_compile format
+        unsigned length;             //bytes including wildcards
+        unsigned wildcards;
+        unsigned instructions;       //instructions the signature touches
+        unsigned initial_candidates; //matches of the first two bytes
+        double elapsed_ms;
+};
+
+/// generate the shortest signature starting at an offset in .text that matches only there
+/// rel32 branch targets, rip relative displacements and 64 bit immediates are wildcarded
+/// returns false if the offset is not code or no unique signature up to AOB_MAX_SIGNATURE bytes exists
+extern bool aob_generate(unsigned offset, AobSignatureInfo* info);
\ No newline at end of file
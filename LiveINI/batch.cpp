@@ -0,0 +1,219 @@
+#include "batch.h"
+#include "process.h"
+#include "memory_scan.h"
+#include "analysis_cache.h"
+#include "aobscan.h"
+#include "task_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+//images wait here until their size fits, one image always runs even if it is larger than the budget
+struct MemoryBudget {
+	std::mutex lock;
+	std::condition_variable released;
+	uint64_t limit;
+	uint64_t used;
+
+	void acquire(uint64_t bytes) {
+		std::unique_lock<std::mutex> l(lock);
+		released.wait(l, [&] { return !used || (used + bytes <= limit); });
+		used += bytes;
+	}
+
+	void release(uint64_t bytes) {
+		{
+			std::lock_guard<std::mutex> l(lock);
+			used -= bytes;
+		}
+		released.notify_all();
+	}
+};
+
+//two files of the same version (e.g. different storefronts) write the same cache files
+static std::mutex save_lock;
+
+struct BatchSignature {
+	std::string text;
+	AOB_SIG sig;
+};
+
+static std::vector<std::string> list_exe_files(const char* directory) {
+	std::vector<std::string> ret;
+
+	const std::string dir{ directory };
+	WIN32_FIND_DATAA fd;
+	const auto find = FindFirstFileA((dir + "\\*.exe").c_str(), &fd);
+	if (find == INVALID_HANDLE_VALUE) return ret;
+
+	do {
+		if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+		ret.push_back(dir + "\\" + fd.cFileName);
+	} while (FindNextFileA(find, &fd));
+	FindClose(find);
+
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+//SizeOfImage from the pe header, the mapped image never needs more than that
+static uint64_t image_cost(const char* path) {
+	FILE* f = NULL;
+	fopen_s(&f, path, "rb");
+	if (!f) return 0;
+
+	char header[4096]{};
+	const auto read = fread(header, 1, sizeof(header), f);
+	fclose(f);
+
+	IMAGE_DOS_HEADER hdr{};
+	IMAGE_NT_HEADERS64 nt{};
+	if (read < sizeof(hdr)) return 0;
+	memcpy(&hdr, header, sizeof(hdr));
+	if ((hdr.e_magic != IMAGE_DOS_SIGNATURE) || (hdr.e_lfanew <= 0) || ((uint64_t)hdr.e_lfanew + sizeof(nt) > read)) return 0;
+	memcpy(&nt, header + hdr.e_lfanew, sizeof(nt));
+	return nt.OptionalHeader.SizeOfImage;
+}
+
+static bool load_signatures(const char* path, std::vector<BatchSignature>& out) {
+	FILE* f = NULL;
+	fopen_s(&f, path, "rb");
+	if (!f) {
+		Log("Could not open %s", path);
+		return false;
+	}
+
+	char line[1024];
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (!*line) continue;
+
+		//aob_compile asserts on anything that is not hex
+		const auto valid = (strspn(line, "0123456789abcdefABCDEF? ") == strlen(line));
+		const auto sig = valid ? aob_compile(line) : NULL;
+		if (!sig) {
+			Log("Skipping invalid signature: %s", line);
+			continue;
+		}
+		out.push_back(BatchSignature{ line, sig });
+	}
+	fclose(f);
+	return true;
+}
+
+//every match in .text, same as the aob tab without the index, one line per signature
+static std::string signature_hits(const ProcessInfo& p, const std::vector<BatchSignature>& signatures) {
+	std::string ret;
+	char hit[32];
+	std::vector<uint32_t> offsets;
+
+	const auto& text = p.exe.text;
+	for (const auto& s : signatures) {
+		ret += s.text;
+		aob_scan_all(p.buffer, text.offset, text.offset + text.size, s.sig, offsets);
+		for (const auto offset : offsets) {
+			snprintf(hit, sizeof(hit), "\tStarfield.exe+%X", offset);
+			ret += hit;
+		}
+		ret += "\r\n";
+	}
+	return ret;
+}
+
+static bool save_signature_hits(const ProcessInfo::ExeInfo::VersionInfo& v, const std::string& hits) {
+	char path[MAX_PATH];
+	snprintf(path, sizeof(path), "analysis_cache/%u.%u.%u.%u.sig.txt", v.major, v.minor, v.build, v.revision);
+
+	FILE* f = NULL;
+	fopen_s(&f, path, "wb");
+	if (!f) {
+		Log("Could not open %s for writing", path);
+		return false;
+	}
+	const auto written = fwrite(hits.data(), 1, hits.size(), f);
+	fclose(f);
+	return (written == hits.size());
+}
+
+static bool analyze_image(const char* path, const std::vector<BatchSignature>& signatures) {
+	ProcessInfo p{};
+	if (!OpenExeFile(path, 0, p)) return false;
+
+	perform_exe_section_analysis(p);
+	bool ok = perform_exe_version_analysis(p);
+	if (ok) {
+		turbo_vtable_algorithm(p);
+
+		AnalysisCache cache;
+		analysis_capture(cache, p);
+		const auto hits = signature_hits(p, signatures);
+
+		const auto cache_path = analysis_cache_path(p.exe.version);
+		std::lock_guard<std::mutex> lock(save_lock);
+		ok = analysis_cache_save(cache, cache_path.c_str());
+		if (ok && !signatures.empty()) ok = save_signature_hits(p.exe.version, hits);
+
+		const auto& v = p.exe.version;
+		Log("%s: %u.%u.%u.%u, %u classes", path, v.major, v.minor, v.build, v.revision, (unsigned)p.rtti_map.size());
+	}
+
+	CloseExeFile(p);
+	return ok;
+}
+
+extern BatchStats batch_analyze(const BatchOptions& options) {
+	BatchStats stats{};
+
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	std::vector<BatchSignature> signatures;
+	if (options.signatures && !load_signatures(options.signatures, signatures)) return stats;
+
+	const auto files = list_exe_files(options.directory);
+	stats.images = (unsigned)files.size();
+	if (files.empty()) {
+		Log("No exe files in %s", options.directory);
+	}
+
+	MemoryBudget budget;
+	budget.limit = options.memory_budget ? options.memory_budget : BATCH_DEFAULT_BUDGET;
+	budget.used = 0;
+
+	unsigned workers = options.workers ? options.workers : task_pool_threads();
+	if (workers > files.size()) workers = (unsigned)files.size();
+
+	std::atomic<size_t> next{ 0 };
+	std::atomic<unsigned> analyzed{ 0 };
+	std::atomic<unsigned> failed{ 0 };
+
+	//each worker task takes the next image until none are left, the analysis inside runs on the same pool
+	TaskGroup group;
+	for (unsigned w = 0; w < workers; ++w) {
+		task_submit([&] {
+			for (size_t i = next++; i < files.size(); i = next++) {
+				const auto cost = image_cost(files[i].c_str());
+				budget.acquire(cost);
+				const auto ok = analyze_image(files[i].c_str(), signatures);
+				budget.release(cost);
+				(ok ? analyzed : failed)++;
+			}
+		}, &group);
+	}
+	task_wait(group);
+
+	for (auto& s : signatures) aob_free(s.sig);
+
+	QueryPerformanceCounter(&end);
+	stats.analyzed = analyzed;
+	stats.failed = failed;
+	stats.elapsed_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+	stats.images_per_minute = stats.elapsed_ms ? (stats.analyzed * 60000.0 / stats.elapsed_ms) : 0.0;
+
+	Log("Batch: %u images, %u analyzed, %u failed in %.1fs (%.1f images/min, %u workers, %.0fMB budget)",
+		stats.images, stats.analyzed, stats.failed, stats.elapsed_ms / 1000.0, stats.images_per_minute,
+		workers, (double)budget.limit / (1024.0 * 1024.0));
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "main.h"
+
+//offline analysis of a directory of exe files, e.g. every shipped Starfield.exe
+//each file is mapped and analyzed on a worker of its own and saved to analysis_cache/<version>.bin
+
+constexpr uint64_t BATCH_DEFAULT_BUDGET = 4ULL << 30; //bytes of images mapped at once
+
+struct BatchOptions {
+	const char* directory;
+	const char* signatures; //optional file with one aob signature per line, hits go to analysis_cache/<version>.sig.txt
+	uint64_t memory_budget; //0 for BATCH_DEFAULT_BUDGET
+	unsigned workers;       //0 for one per task pool thread
+};
+
+struct BatchStats {
+	unsigned images;
+	unsigned analyzed;
+	unsigned failed;
+	double elapsed_ms;
+	double images_per_minute;
+};
+
+/// analyze every *.exe in options.directory, a worker only starts on an image once
+/// its SizeOfImage fits in the memory budget next to the images already mapped
+extern BatchStats batch_analyze(const BatchOptions& options);
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "class_correlate.h"
+
+static uint32_t count_same_methods(const AnalysisCache& older, const CacheClass& a, const AnalysisCache& newer, const CacheClass& b) {
+	const auto n = (a.func_count < b.func_count) ? a.func_count : b.func_count;
+	uint32_t same = 0;
+	for (uint32_t i = 0; i < n; ++i) {
+		same += (older.method_hash[a.first_method + i] == newer.method_hash[b.first_method + i]);
+	}
+	return same;
+}
+
+extern void correlate_classes(const AnalysisCache& older, const AnalysisCache& newer, ClassCorrelation& out) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	out.rows.clear();
+	memset(out.counts, 0, sizeof(out.counts));
+
+	const auto old_count = (uint32_t)older.classes.size();
+	const auto new_count = (uint32_t)newer.classes.size();
+
+	std::unordered_map<std::string, uint32_t> by_name;
+	by_name.reserve(new_count);
+	for (uint32_t i = 0; i < new_count; ++i) {
+		by_name.emplace(newer.classes[i].name, i);
+	}
+
+	std::vector<bool> new_matched(new_count);
+	out.rows.resize(old_count);
+
+	//pass 1: mangled name
+	for (uint32_t i = 0; i < old_count; ++i) {
+		auto& row = out.rows[i];
+		row.old_class = i;
+		row.new_class = UINT32_MAX;
+		row.match = ClassMatch_Removed;
+
+		const auto found = by_name.find(older.classes[i].name);
+		if (found == by_name.end()) continue;
+
+		row.new_class = found->second;
+		row.match = ClassMatch_Name;
+		new_matched[found->second] = true;
+	}
+
+	//pass 2: the leftovers by method count and fingerprint, only when the pair is unique on both sides
+	const auto key = [](const CacheClass& c) -> uint64_t { return c.fingerprint ^ ((uint64_t)c.func_count << 48); };
+	std::unordered_map<uint64_t, uint32_t> by_fingerprint;
+	std::unordered_map<uint64_t, uint32_t> old_fingerprints;
+	for (uint32_t i = 0; i < new_count; ++i) {
+		if (new_matched[i]) continue;
+		const auto k = key(newer.classes[i]);
+		const auto ins = by_fingerprint.emplace(k, i);
+		if (!ins.second) ins.first->second = UINT32_MAX;
+	}
+	for (uint32_t i = 0; i < old_count; ++i) {
+		if (out.rows[i].match != ClassMatch_Removed) continue;
+		++old_fingerprints[key(older.classes[i])];
+	}
+	for (uint32_t i = 0; i < old_count; ++i) {
+		auto& row = out.rows[i];
+		if (row.match != ClassMatch_Removed) continue;
+		const auto k = key(older.classes[i]);
+		if (old_fingerprints[k] != 1) continue;
+		const auto found = by_fingerprint.find(k);
+		if ((found == by_fingerprint.end()) || (found->second == UINT32_MAX)) continue;
+
+		row.new_class = found->second;
+		row.match = ClassMatch_Fingerprint;
+		new_matched[found->second] = true;
+	}
+
+	for (auto& row : out.rows) {
+		if (row.new_class != UINT32_MAX) {
+			row.same_methods = count_same_methods(older, older.classes[row.old_class], newer, newer.classes[row.new_class]);
+		}
+		++out.counts[row.match];
+	}
+
+	for (uint32_t i = 0; i < new_count; ++i) {
+		if (new_matched[i]) continue;
+		out.rows.push_back(ClassMigration{ UINT32_MAX, i, ClassMatch_Added, 0 });
+		++out.counts[ClassMatch_Added];
+	}
+
+	QueryPerformanceCounter(&end);
+	out.elapsed_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+}
+
+extern bool migrate_offset(const AnalysisCache& older, const AnalysisCache& newer, const ClassCorrelation& c, uint32_t old_rva, uint32_t* new_rva, std::string* how) {
+	char text[512];
+
+	//inside a vtable, classes are sorted by vtable offset so the owner is the last one starting at or before the rva
+	const auto upper = std::upper_bound(
+		older.classes.begin(),
+		older.classes.end(),
+		old_rva,
+		[](uint32_t rva, const CacheClass& x) { return rva < x.vtable_offset; });
+	if (upper != older.classes.begin()) {
+		const auto k = (uint32_t)(upper - older.classes.begin() - 1);
+		const auto& oc = older.classes[k];
+		const auto slot_offset = old_rva - oc.vtable_offset;
+		if (slot_offset < oc.func_count * sizeof(uintptr_t)) {
+			const auto& row = c.rows[k];
+			if (row.new_class == UINT32_MAX) return false;
+			const auto& nc = newer.classes[row.new_class];
+			if (slot_offset >= nc.func_count * sizeof(uintptr_t)) return false;
+			*new_rva = nc.vtable_offset + slot_offset;
+			snprintf(text, sizeof(text), "vtable slot %u of %s", slot_offset / (uint32_t)sizeof(uintptr_t), nc.name.c_str());
+			*how = text;
+			return true;
+		}
+	}
+
+	//a method, use the first correlated class that has it in its vtable
+	for (uint32_t k = 0; k < (uint32_t)older.classes.size(); ++k) {
+		const auto& oc = older.classes[k];
+		const auto& row = c.rows[k];
+		if (row.new_class == UINT32_MAX) continue;
+		const auto& nc = newer.classes[row.new_class];
+		for (uint32_t i = 0; (i < oc.func_count) && (i < nc.func_count); ++i) {
+			if (older.method_rva[oc.first_method + i] != old_rva) continue;
+			*new_rva = newer.method_rva[nc.first_method + i];
+			const bool same = (older.method_hash[oc.first_method + i] == newer.method_hash[nc.first_method + i]);
+			snprintf(text, sizeof(text), "method %u of %s (%s)", i, nc.name.c_str(), same ? "same fingerprint" : "body changed");
+			*how = text;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+extern const char* class_match_name(ClassMatch m) {
+	switch (m) {
+	case ClassMatch_Name: return "Name";
+	case ClassMatch_Fingerprint: return "Fingerprint";
+	case ClassMatch_Removed: return "Removed";
+	case ClassMatch_Added: return "Added";
+	default: return "(error)";
+	}
+}
\ No newline at end of file
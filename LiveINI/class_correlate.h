@@ -0,0 +1,34 @@
+#pragma once
+
+#include "analysis_cache.h"
+
+//matches the classes of an older analysis to the current one so stored offsets can be migrated
+
+enum ClassMatch : uint8_t {
+	ClassMatch_Name,        //same mangled name
+	ClassMatch_Fingerprint, //renamed (e.g. anonymous namespace), same method count and method fingerprints
+	ClassMatch_Removed,     //no counterpart in the current build
+	ClassMatch_Added,       //only in the current build
+	ClassMatch_Count,
+};
+
+struct ClassMigration {
+	uint32_t old_class; //index into the old cache, UINT32_MAX for added classes
+	uint32_t new_class; //index into the new cache, UINT32_MAX for removed classes
+	ClassMatch match;
+	uint32_t same_methods; //slots whose fingerprint did not change
+};
+
+struct ClassCorrelation {
+	std::vector<ClassMigration> rows; //old classes in vtable order followed by added classes
+	uint32_t counts[ClassMatch_Count];
+	double elapsed_ms;
+};
+
+extern void correlate_classes(const AnalysisCache& older, const AnalysisCache& newer, ClassCorrelation& out);
+
+/// translate an rva of the old build that points into a vtable or at a vtable method
+/// returns false if the rva is not part of any correlated class, how describes the mapping
+extern bool migrate_offset(const AnalysisCache& older, const AnalysisCache& newer, const ClassCorrelation& c, uint32_t old_rva, uint32_t* new_rva, std::string* how);
+
+extern const char* class_match_name(ClassMatch m);
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "class_hierarchy.h"
+#include "parallel.h"
+
+static ClassHierarchy Hierarchy{};
+static uint32_t HierarchyGeneration = 0;
+
+//x64 rtti layout, every pointer is an image offset
+struct CompleteObjectLocator {
+	uint32_t signature;
+	uint32_t offset;
+	uint32_t cd_offset;
+	uint32_t type_descriptor;
+	uint32_t class_descriptor;
+	uint32_t self;
+};
+
+struct ClassHierarchyDescriptor {
+	uint32_t signature;
+	uint32_t attributes;
+	uint32_t num_base_classes;
+	uint32_t base_class_array;
+};
+
+struct BaseClassDescriptor {
+	uint32_t type_descriptor;
+	uint32_t num_contained_bases;
+	int32_t mdisp;
+	int32_t pdisp;
+	int32_t vdisp;
+	uint32_t attributes;
+	uint32_t class_descriptor;
+};
+
+static constexpr uint32_t TYPE_DESCRIPTOR_NAME = 16; //name follows the vftable pointer and spare field
+static constexpr uint32_t MAX_BASE_CLASSES = 4096;
+
+template<typename T>
+static bool read_image(const ProcessInfo& p, uint64_t offset, T* out) {
+	if (offset + sizeof(T) > p.buffer_size) return false;
+	memcpy(out, (const char*)p.buffer + offset, sizeof(T));
+	return true;
+}
+
+static bool valid_type_descriptor(const ProcessInfo& p, uint32_t td) {
+	const auto& d = p.exe.data;
+	return (td >= d.offset) && (td + TYPE_DESCRIPTOR_NAME < d.offset + d.size) &&
+		(((const char*)p.buffer)[td + TYPE_DESCRIPTOR_NAME] == '.');
+}
+
+struct ClassEdges {
+	uint32_t type_descriptor;
+	std::vector<uint32_t> bases; //type descriptors of the direct bases
+};
+
+//the base class array lists the class itself followed by every base in depth first order
+//a direct base is followed by its own num_contained_bases entries, skipping them leaves only direct bases
+static void parse_class(const ProcessInfo& p, uint32_t vtable_offset, ClassEdges* out) {
+	uint64_t meta;
+	if (!vtable_offset || !read_image(p, vtable_offset - sizeof(meta), &meta)) return;
+	if (meta < p.base_address) return;
+
+	CompleteObjectLocator col;
+	ClassHierarchyDescriptor chd;
+	if (!read_image(p, meta - p.base_address, &col)) return;
+	if (!valid_type_descriptor(p, col.type_descriptor)) return;
+	out->type_descriptor = col.type_descriptor;
+
+	if (!read_image(p, col.class_descriptor, &chd)) return;
+	if (chd.num_base_classes > MAX_BASE_CLASSES) return;
+
+	for (uint32_t i = 1; i < chd.num_base_classes; ) {
+		uint32_t bcd_offset;
+		BaseClassDescriptor bcd;
+		if (!read_image(p, chd.base_class_array + (uint64_t)i * sizeof(uint32_t), &bcd_offset)) return;
+		if (!read_image(p, bcd_offset, &bcd)) return;
+		if (!valid_type_descriptor(p, bcd.type_descriptor)) return;
+
+		//a base reached through two paths (virtual inheritance) is listed once
+		if (std::find(out->bases.begin(), out->bases.end(), bcd.type_descriptor) == out->bases.end()) {
+			out->bases.push_back(bcd.type_descriptor);
+		}
+		i += 1 + bcd.num_contained_bases;
+	}
+}
+
+extern void class_hierarchy_reset(void) {
+	Hierarchy = ClassHierarchy{};
+	++HierarchyGeneration;
+}
+
+extern const ClassHierarchy& class_hierarchy(void) {
+	return Hierarchy;
+}
+
+extern void class_hierarchy_install(ClassHierarchy&& h) {
+	Hierarchy = std::move(h);
+	++HierarchyGeneration;
+}
+
+extern uint32_t class_hierarchy_generation(void) {
+	return HierarchyGeneration;
+}
+
+extern void class_hierarchy_build(void) {
+	class_hierarchy_build(GameProcessInfo, Hierarchy);
+	++HierarchyGeneration;
+}
+
+extern void class_hierarchy_build(const ProcessInfo& p, ClassHierarchy& h) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	h = ClassHierarchy{};
+
+	std::vector<uint32_t> vtables;
+	vtables.reserve(p.rtti_map.size());
+	for (const auto& x : p.rtti_map) vtables.push_back(x.second.vtable_offset);
+
+	std::vector<ClassEdges> edges(vtables.size(), ClassEdges{});
+	parallel_chunks(vtables.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) parse_class(p, vtables[i], &edges[i]);
+	});
+
+	//every type descriptor becomes a node, numbered in name order
+	std::vector<uint32_t> tds;
+	for (const auto& e : edges) {
+		if (!e.type_descriptor) continue;
+		tds.push_back(e.type_descriptor);
+		tds.insert(tds.end(), e.bases.begin(), e.bases.end());
+	}
+	std::sort(tds.begin(), tds.end());
+	tds.erase(std::unique(tds.begin(), tds.end()), tds.end());
+
+	const auto td_name = [&](uint32_t td) { return (const char*)p.buffer + td + TYPE_DESCRIPTOR_NAME; };
+	std::vector<uint32_t> order(tds.size());
+	for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return strcmp(td_name(tds[a]), td_name(tds[b])) < 0; });
+
+	std::vector<uint32_t> td_node(tds.size()); //parallel to tds
+	h.names.reserve(order.size());
+	for (uint32_t id = 0; id < order.size(); ++id) {
+		td_node[order[id]] = id;
+		h.names.emplace_back(td_name(tds[order[id]]));
+	}
+	const auto node_of = [&](uint32_t td) {
+		return td_node[std::lower_bound(tds.begin(), tds.end(), td) - tds.begin()];
+	};
+
+	//the same class can be found through several vtables (secondary vtables of multiple inheritance)
+	std::vector<std::pair<uint32_t, uint32_t>> pairs; //(node, base)
+	for (const auto& e : edges) {
+		if (!e.type_descriptor) continue;
+		const auto node = node_of(e.type_descriptor);
+		for (const auto b : e.bases) pairs.emplace_back(node, node_of(b));
+	}
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+	const auto n = h.names.size();
+	h.base_begin.assign(n + 1, 0);
+	h.base_ids.reserve(pairs.size());
+	for (const auto& pair : pairs) {
+		++h.base_begin[pair.first + 1];
+		h.base_ids.push_back(pair.second);
+	}
+	for (size_t i = 0; i < n; ++i) h.base_begin[i + 1] += h.base_begin[i];
+
+	hierarchy_link_derived(h);
+
+	QueryPerformanceCounter(&end);
+	Log("Class hierarchy: %u classes, %u base edges, %.2fms", (unsigned)n, (unsigned)pairs.size(),
+		(double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart);
+}
+
+extern void hierarchy_link_derived(ClassHierarchy& h) {
+	const auto n = h.names.size();
+	h.derived_begin.assign(n + 1, 0);
+	h.derived_ids.resize(h.base_ids.size());
+
+	for (const auto b : h.base_ids) ++h.derived_begin[b + 1];
+	for (size_t i = 0; i < n; ++i) h.derived_begin[i + 1] += h.derived_begin[i];
+
+	//visiting nodes in order keeps each derived list sorted
+	std::vector<uint32_t> fill(h.derived_begin.begin(), h.derived_begin.end() - 1);
+	for (uint32_t node = 0; node < n; ++node) {
+		for (auto e = h.base_begin[node]; e < h.base_begin[node + 1]; ++e) {
+			h.derived_ids[fill[h.base_ids[e]]++] = node;
+		}
+	}
+}
+
+extern uint32_t hierarchy_find(const ClassHierarchy& h, const char* name) {
+	const auto it = std::lower_bound(h.names.begin(), h.names.end(), name, [](const std::string& a, const char* b) { return strcmp(a.c_str(), b) < 0; });
+	if ((it == h.names.end()) || strcmp(it->c_str(), name)) return HIERARCHY_NONE;
+	return (uint32_t)(it - h.names.begin());
+}
+
+extern size_t hierarchy_bases(const ClassHierarchy& h, uint32_t id, const uint32_t** first) {
+	*first = h.base_ids.data() + h.base_begin[id];
+	return h.base_begin[id + 1] - h.base_begin[id];
+}
+
+extern size_t hierarchy_derived(const ClassHierarchy& h, uint32_t id, const uint32_t** first) {
+	*first = h.derived_ids.data() + h.derived_begin[id];
+	return h.derived_begin[id + 1] - h.derived_begin[id];
+}
+
+extern void hierarchy_subclasses(const ClassHierarchy& h, uint32_t id, std::vector<uint32_t>& out) {
+	out.clear();
+	std::vector<bool> seen(h.names.size());
+	std::vector<uint32_t> stack{ id };
+	seen[id] = true;
+
+	while (!stack.empty()) {
+		const auto node = stack.back();
+		stack.pop_back();
+		for (auto e = h.derived_begin[node]; e < h.derived_begin[node + 1]; ++e) {
+			const auto d = h.derived_ids[e];
+			if (seen[d]) continue;
+			seen[d] = true;
+			out.push_back(d);
+			stack.push_back(d);
+		}
+	}
+	std::sort(out.begin(), out.end());
+}
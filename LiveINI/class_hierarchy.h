@@ -0,0 +1,41 @@
+#pragma once
+
+#include "main.h"
+
+//inheritance graph from the msvc rtti ClassHierarchyDescriptor and BaseClassArray of every vtable
+//nodes are every type descriptor seen, classes without a vtable only show up as bases
+//edges are stored in csr form in both directions
+
+struct ClassHierarchy {
+	std::vector<std::string> names;       //sorted, the node id is the index
+	std::vector<uint32_t> base_begin;     //direct bases of node i are base_ids[base_begin[i] .. base_begin[i + 1])
+	std::vector<uint32_t> base_ids;
+	std::vector<uint32_t> derived_begin;  //transpose of the base edges
+	std::vector<uint32_t> derived_ids;
+};
+
+constexpr uint32_t HIERARCHY_NONE = UINT32_MAX;
+
+//rebuild the hierarchy of the current rtti_map, the descriptors are parsed on all cores
+extern void class_hierarchy_build(void);
+//build the hierarchy of any analyzed image into h
+extern void class_hierarchy_build(const ProcessInfo& p, ClassHierarchy& h);
+extern void class_hierarchy_reset(void);
+extern const ClassHierarchy& class_hierarchy(void);
+//use a hierarchy loaded from the analysis cache of this game version instead of building it
+extern void class_hierarchy_install(ClassHierarchy&& h);
+//changes whenever the current hierarchy is built, installed or reset, for caches derived from it
+extern uint32_t class_hierarchy_generation(void);
+
+//fill derived_begin/derived_ids from the base edges
+extern void hierarchy_link_derived(ClassHierarchy& h);
+
+//node id of a mangled name, or HIERARCHY_NONE
+extern uint32_t hierarchy_find(const ClassHierarchy& h, const char* name);
+
+//direct bases or direct subclasses of a node, first is set to the start of the range
+extern size_t hierarchy_bases(const ClassHierarchy& h, uint32_t id, const uint32_t** first);
+extern size_t hierarchy_derived(const ClassHierarchy& h, uint32_t id, const uint32_t** first);
+
+//every class that inherits from id directly or indirectly, sorted
+extern void hierarchy_subclasses(const ClassHierarchy& h, uint32_t id, std::vector<uint32_t>& out);
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "cli.h"
+#include "main.h"
+#include "process.h"
+#include "memory_scan.h"
+#include "setting_export.h"
+#include "profile.h"
+#include "batch.h"
+#include "large_pages.h"
+#include "scan_kernels.h"
+#include "task_pool.h"
+#include "gentle.h"
+#include "image_sections.h"
+
+#include <io.h>
+#include <fcntl.h>
+
+enum CliExit : int {
+	CliExit_Ok = 0,
+	CliExit_Failed = 1,      //could not attach or analyze
+	CliExit_ApplyFailed = 2, //some settings could not be applied
+	CliExit_Usage = 64,
+};
+
+struct CliOptions {
+	DWORD pid;
+	const char* exe_name;
+	const char* image;
+	const char* exe_file;
+	uintptr_t base;
+	const char* apply;
+	const char* save_image;
+	const char* export_path;
+	const char* diff_old;
+	const char* diff_new;
+	BatchOptions batch;
+	uint64_t bench_pages;
+	const char* kernels;
+	TaskPoolOptions pool;
+	GentleOptions gentle;
+	bool test_kernels;
+	bool dump;
+};
+
+static void print_usage() {
+	fprintf(stderr,
+		"usage: LiveINI --headless [source] [actions]\n"
+		"source (default: attach to Starfield.exe):\n"
+		"  --pid <id>            attach to a process id\n"
+		"  --exe <name.exe>      attach to a process by executable name\n"
+		"  --image <file>        analyze a raw dump of the loaded module instead of a process\n"
+		"  --exe-file <file>     analyze an exe file from disk, e.g. an archived build\n"
+		"  --base <hex>          load address of the dumped module or exe file (default: pe image base)\n"
+		"actions:\n"
+		"  --dump                write all settings to stdout in the search_results.txt format\n"
+		"  --apply <file>        apply an ini profile with one batched write\n"
+		"  --export <file>       write all settings to a binary export\n"
+		"  --save-image <file>   save the module image, for later use with --image\n"
+		"  --diff <old> <new>    compare two binary exports (type, default value and origin), no game needed\n"
+		"  --batch <dir>         analyze every exe file in a directory into analysis_cache, no game needed\n"
+		"    --signatures <file>   aob signatures to search in each exe, one per line\n"
+		"    --budget <MB>         image memory mapped at once (default 4096)\n"
+		"    --workers <n>         images analyzed at once (default: one per pool thread)\n"
+		"  --bench-pages <MB>    time the scan kernels on large and 4KB pages, no game needed\n"
+		"  --test-kernels        check and time every scan kernel variant this cpu supports, no game needed\n"
+		"  --kernels <name>      use the scalar, sse42, avx2 or avx512 scan kernels instead of the best supported\n"
+		"  --threads <n>         worker threads for analysis and scans (default: one per core)\n"
+		"  --affinity <hex>      core mask the worker threads may run on (default: all)\n"
+		"  --gentle <MB/s>       pace reads of the game's memory and run the workers at the lowest priority\n"
+		"    --frame-time <hex>    address of the game's frame time float, the read rate backs off on slow frames\n");
+}
+
+extern bool cli_requested(int argc, char** argv) {
+	for (int i = 1; i < argc; ++i) {
+		if (!strncmp(argv[i], "--", 2)) return true;
+	}
+	return false;
+}
+
+static bool parse_options(int argc, char** argv, CliOptions& o) {
+	for (int i = 1; i < argc; ++i) {
+		const char* a = argv[i];
+		const bool has_value = (i + 1 < argc);
+		if (!strcmp(a, "--headless")) continue;
+		else if (!strcmp(a, "--dump")) o.dump = true;
+		else if (!strcmp(a, "--pid") && has_value) o.pid = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(a, "--exe") && has_value) o.exe_name = argv[++i];
+		else if (!strcmp(a, "--image") && has_value) o.image = argv[++i];
+		else if (!strcmp(a, "--exe-file") && has_value) o.exe_file = argv[++i];
+		else if (!strcmp(a, "--base") && has_value) o.base = (uintptr_t)_strtoui64(argv[++i], NULL, 16);
+		else if (!strcmp(a, "--apply") && has_value) o.apply = argv[++i];
+		else if (!strcmp(a, "--save-image") && has_value) o.save_image = argv[++i];
+		else if (!strcmp(a, "--export") && has_value) o.export_path = argv[++i];
+		else if (!strcmp(a, "--batch") && has_value) o.batch.directory = argv[++i];
+		else if (!strcmp(a, "--signatures") && has_value) o.batch.signatures = argv[++i];
+		else if (!strcmp(a, "--budget") && has_value) o.batch.memory_budget = _strtoui64(argv[++i], NULL, 10) << 20;
+		else if (!strcmp(a, "--workers") && has_value) o.batch.workers = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(a, "--test-kernels")) o.test_kernels = true;
+		else if (!strcmp(a, "--kernels") && has_value) o.kernels = argv[++i];
+		else if (!strcmp(a, "--threads") && has_value) o.pool.threads = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(a, "--affinity") && has_value) o.pool.affinity = _strtoui64(argv[++i], NULL, 16);
+		else if (!strcmp(a, "--gentle") && has_value) o.gentle.rate_mb = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(a, "--frame-time") && has_value) o.gentle.frame_time = (uintptr_t)_strtoui64(argv[++i], NULL, 16);
+		else if (!strcmp(a, "--bench-pages") && has_value) o.bench_pages = _strtoui64(argv[++i], NULL, 10) << 20;
+		else if (!strcmp(a, "--diff") && (i + 2 < argc)) {
+			o.diff_old = argv[++i];
+			o.diff_new = argv[++i];
+		}
+		else {
+			fprintf(stderr, "unknown or incomplete argument: %s\n", a);
+			return false;
+		}
+	}
+	return true;
+}
+
+//a gui subsystem process starts without standard streams unless the caller redirected them
+static void attach_console() {
+	if ((_fileno(stdout) < 0) || (_fileno(stderr) < 0)) {
+		if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+			FILE* f = NULL;
+			if (_fileno(stdout) < 0) freopen_s(&f, "CONOUT$", "w", stdout);
+			if (_fileno(stderr) < 0) freopen_s(&f, "CONOUT$", "w", stderr);
+		}
+	}
+
+	//rows are already \r\n terminated
+	if (_fileno(stdout) >= 0) _setmode(_fileno(stdout), _O_BINARY);
+}
+
+static bool apply_profile(const char* path) {
+	std::vector<ProfileEntry> entries;
+	if (!profile_load(path, entries)) return false;
+	const auto r = profile_apply(entries, scanned_settings(), NULL);
+	return !(r.unknown | r.unsupported | r.invalid | r.failed);
+}
+
+static int diff_exports(const char* older_path, const char* newer_path) {
+	ExportView older, newer;
+	if (!export_open(older_path, &older)) return CliExit_Failed;
+	if (!export_open(newer_path, &newer)) {
+		export_close(&older);
+		return CliExit_Failed;
+	}
+
+	const auto stats = export_diff(older, newer, stdout);
+	fflush(stdout);
+	Log("Diff: %u added, %u removed, %u changed, %u unchanged", stats.added, stats.removed, stats.changed, stats.unchanged);
+
+	export_close(&newer);
+	export_close(&older);
+	return CliExit_Ok;
+}
+
+static void analyze() {
+	// each operation builds more info about the exe and is used by the next operation
+	perform_exe_section_analysis();
+	perform_exe_version_analysis();
+	turbo_vtable_algorithm();
+	scan_vtable();
+	Log("Found %u settings", (unsigned)scanned_settings().size());
+}
+
+extern int cli_main(int argc, char** argv) {
+	attach_console();
+	log_to_stderr(true);
+
+	CliOptions o{};
+	if (!parse_options(argc, argv, o)) {
+		print_usage();
+		return CliExit_Usage;
+	}
+	if (o.diff_old) {
+		return diff_exports(o.diff_old, o.diff_new);
+	}
+	task_pool_configure(o.pool);
+	if (o.gentle.rate_mb) {
+		o.gentle.enabled = true;
+		gentle_configure(o.gentle);
+	}
+	if (o.kernels && !scan_kernels_force(scan_kernels_parse(o.kernels))) {
+		return CliExit_Usage;
+	}
+	if (o.test_kernels) {
+		return scan_kernels_self_test() ? CliExit_Ok : CliExit_Failed;
+	}
+	if (o.bench_pages) {
+		large_pages_benchmark(o.bench_pages);
+		return CliExit_Ok;
+	}
+	if (o.batch.directory) {
+		const auto stats = batch_analyze(o.batch);
+		return (stats.images && !stats.failed) ? CliExit_Ok : CliExit_Failed;
+	}
+	if (!o.dump && !o.apply && !o.save_image && !o.export_path) {
+		print_usage();
+		return CliExit_Usage;
+	}
+
+	bool ok = false;
+	if (o.image) {
+		ok = LoadImageFile(o.image, o.base);
+	}
+	else if (o.exe_file) {
+		ok = LoadExeFile(o.exe_file, o.base);
+	}
+	else {
+		auto pid = o.pid;
+		if (!pid) pid = GetProcessIdByExeName(o.exe_name ? o.exe_name : "Starfield.exe");
+		if (!pid && !o.exe_name) pid = GetProcessIdByWindowTitle(L"Starfield");
+		ok = OpenGameProcess(pid);
+	}
+
+	if (!ok) {
+		CloseGameProcess();
+		return CliExit_Failed;
+	}
+	analyze();
+
+	int ret = CliExit_Ok;
+	if (o.apply) {
+		if (!apply_profile(o.apply)) ret = CliExit_ApplyFailed;
+
+		//refresh the image so the dump shows the applied values, an image source was written in place
+		//the settings live in the sections read from the process, the ones mapped from the exe file are not read again
+		if (o.dump || o.export_path) {
+			if (GameProcessInfo.process) {
+				image_sections_build();
+				for (const auto& s : image_sections()) {
+					if (s.source != ImageSection_Process) continue;
+					if (!RPM(GameProcessInfo.base_address + s.offset, (char*)GameProcessInfo.buffer + s.offset, s.size)) {
+						Log("Could not read %s again, the dump may show values from before the apply", s.name);
+					}
+				}
+			}
+			scan_vtable();
+		}
+	}
+
+	if (o.dump || o.export_path) {
+		write_settings_text(o.dump ? stdout : NULL, o.export_path);
+		fflush(stdout);
+	}
+
+	if (o.save_image && !SaveImageFile(o.save_image)) {
+		ret = CliExit_Failed;
+	}
+
+	CloseGameProcess();
+	return ret;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+//headless front-end, runs the analysis pipeline without creating a window or d3d device
+//settings are streamed to stdout in the search_results.txt format and log output goes to stderr
+
+//true if the command line asks for headless mode
+extern bool cli_requested(int argc, char** argv);
+
+//returns the process exit code
+extern int cli_main(int argc, char** argv);
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "main.h"
+#include "memory_scan.h"
+#include "setting_diff.h"
+
+static ExportView Previous{};
+static SettingDiff Diff{};
+static std::vector<uint32_t> Visible{}; //rows of Diff that pass the category filter
+static bool Show[SettingDiff_Count] = { true, true, true, true, true };
+
+static void filter_rows() {
+        Visible.clear();
+        for (uint32_t i = 0; i < (uint32_t)Diff.rows.size(); ++i) {
+                if (Show[Diff.rows[i].kind]) Visible.push_back(i);
+        }
+}
+
+static void load_and_compare(const char* path) {
+        export_close(&Previous);
+        Diff.rows.clear();
+        Visible.clear();
+
+        if (!export_open(path, &Previous)) return;
+        setting_diff(Previous, scanned_settings(), Diff);
+        filter_rows();
+        Log("Diff against %s: %u added, %u removed, %u default changed, %u type changed, %u origin changed in %.2fms",
+                path,
+                Diff.counts[SettingDiff_Added],
+                Diff.counts[SettingDiff_Removed],
+                Diff.counts[SettingDiff_DefaultChanged],
+                Diff.counts[SettingDiff_TypeChanged],
+                Diff.counts[SettingDiff_OriginChanged],
+                Diff.elapsed_ms);
+}
+
+extern void draw_diff_window() {
+        static char path[MAX_PATH] = "search_results.bin";
+
+        if (scanned_settings().empty()) {
+                ImGui::Text("Press Scan Starfield in the log window");
+                return;
+        }
+
+        ImGui::InputText("Previous export", path, sizeof(path));
+        ImGui::SameLine();
+        if (ImGui::Button("Compare")) {
+                load_and_compare(path);
+        }
+
+        if (!Previous.header) {
+                ImGui::Text("Load a search_results.bin saved from the Setting tab of an older game version");
+                return;
+        }
+
+        const auto& vo = Previous.header->version;
+        const auto& vn = GameProcessInfo.exe.version;
+        ImGui::Text("%u.%u.%u.%u -> %u.%u.%u.%u, %u unchanged, %.2fms",
+                vo.major, vo.minor, vo.build, vo.revision,
+                vn.major, vn.minor, vn.build, vn.revision,
+                Diff.unchanged, Diff.elapsed_ms);
+
+        bool refilter = false;
+        for (unsigned k = 0; k < SettingDiff_Count; ++k) {
+                char label[64];
+                snprintf(label, sizeof(label), "%s (%u)", setting_diff_kind_name((SettingDiffKind)k), Diff.counts[k]);
+                if (k) ImGui::SameLine();
+                refilter |= ImGui::Checkbox(label, &Show[k]);
+        }
+        if (refilter) filter_rows();
+
+        const auto flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable;
+        if (!ImGui::BeginTable("diff_table", 6, flags)) return;
+
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Change");
+        ImGui::TableSetupColumn("Setting");
+        ImGui::TableSetupColumn("Old Default");
+        ImGui::TableSetupColumn("New Default");
+        ImGui::TableSetupColumn("Old Type");
+        ImGui::TableSetupColumn("New Type");
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clip;
+        clip.Begin((int)Visible.size());
+        while (clip.Step()) {
+                for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
+                        const auto& row = Diff.rows[Visible[i]];
+                        const bool has_old = (row.old_row != UINT32_MAX);
+                        const bool has_new = (row.kind != SettingDiff_Removed);
+                        char old_default[64];
+
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(setting_diff_kind_name(row.kind));
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(row.name.c_str());
+                        ImGui::TableNextColumn();
+                        if (has_old) ImGui::TextUnformatted(export_format_value(Previous, Previous.type[row.old_row], Previous.value_default[row.old_row], old_default, sizeof(old_default)));
+                        ImGui::TableNextColumn();
+                        if (has_new) ImGui::TextUnformatted(row.new_default.c_str());
+                        ImGui::TableNextColumn();
+                        if (has_old) ImGui::TextUnformatted(Setting::GetGameSettingTypeName(Previous.type[row.old_row]));
+                        ImGui::TableNextColumn();
+                        if (has_new) ImGui::TextUnformatted(Setting::GetGameSettingTypeName(row.new_type));
+                }
+        }
+        ImGui::EndTable();
+}
\ No newline at end of file
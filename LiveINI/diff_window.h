@@ -0,0 +1,3 @@
+#pragma once
+
+extern void draw_diff_window();
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "freeze.h"
+
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+static constexpr unsigned FREEZE_MIN_RATE = 1;
+static constexpr unsigned FREEZE_MAX_RATE = 1000;
+
+static struct {
+	std::mutex lock;
+	std::condition_variable wake;
+	std::thread worker;
+	bool running;
+	bool stop;
+
+	std::vector<SettingWrite> entries; //sorted by address
+	uint64_t generation;               //bumped on every change to entries
+	unsigned rate = 20;
+
+	FreezeStats stats;
+	uint64_t total_reads;
+	uint64_t total_writes;
+	double total_cycle_us;
+} Freeze{};
+
+static uint64_t filetime_100ns(const FILETIME& ft) {
+	return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+static uint64_t thread_cpu_100ns() {
+	FILETIME create, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &create, &exit, &kernel, &user)) return 0;
+	return filetime_100ns(kernel) + filetime_100ns(user);
+}
+
+static void freeze_thread() {
+	std::vector<SettingWrite> local;
+	uint64_t local_generation = UINT64_MAX;
+
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+
+	//cpu usage is sampled over windows of about one second
+	uint64_t window_cpu = thread_cpu_100ns();
+	QueryPerformanceCounter(&start);
+	LARGE_INTEGER window_start = start;
+
+	std::unique_lock<std::mutex> lock(Freeze.lock);
+	while (!Freeze.stop) {
+		if (local_generation != Freeze.generation) {
+			local = Freeze.entries;
+			local_generation = Freeze.generation;
+		}
+		lock.unlock();
+
+		QueryPerformanceCounter(&start);
+		const auto batch = Setting::UpdateBatch(local.data(), local.size());
+		QueryPerformanceCounter(&end);
+		const double cycle_us = (double)(end.QuadPart - start.QuadPart) * 1000000.0 / (double)freq.QuadPart;
+
+		lock.lock();
+
+		//settings that no longer pass the vtable/name/default checks are unpinned
+		//if the entries changed during the batch an address may belong to a newer entry, the next cycle checks those
+		uint64_t dropped = 0;
+		for (const auto& w : local) {
+			if ((w.status != SettingWrite_GuardFailed) || (local_generation != Freeze.generation)) continue;
+			const auto found = std::lower_bound(
+				Freeze.entries.begin(),
+				Freeze.entries.end(),
+				w.address,
+				[](const SettingWrite& e, uintptr_t a) { return e.address < a; });
+			if ((found != Freeze.entries.end()) && (found->address == w.address)) {
+				Freeze.entries.erase(found);
+				++dropped;
+			}
+		}
+		if (dropped) {
+			++Freeze.generation;
+			Log("Freeze: unpinned %llu settings that failed a guard check", dropped);
+		}
+
+		auto& st = Freeze.stats;
+		++st.cycles;
+		st.rewritten += batch.written;
+		st.dropped += dropped;
+		st.frozen = (uint32_t)Freeze.entries.size();
+		st.last_cycle_us = cycle_us;
+		Freeze.total_cycle_us += cycle_us;
+		Freeze.total_reads += batch.reads;
+		Freeze.total_writes += batch.writes;
+		st.avg_cycle_us = Freeze.total_cycle_us / (double)st.cycles;
+		st.reads_per_cycle = (double)Freeze.total_reads / (double)st.cycles;
+		st.writes_per_cycle = (double)Freeze.total_writes / (double)st.cycles;
+
+		const double window_s = (double)(end.QuadPart - window_start.QuadPart) / (double)freq.QuadPart;
+		if (window_s >= 1.0) {
+			const auto cpu = thread_cpu_100ns();
+			st.cpu_percent = ((double)(cpu - window_cpu) / 1.0e7) / window_s * 100.0;
+			window_cpu = cpu;
+			window_start = end;
+		}
+
+		if (Freeze.entries.empty()) {
+			Freeze.wake.wait(lock, [] { return Freeze.stop || !Freeze.entries.empty(); });
+		}
+		else {
+			Freeze.wake.wait_for(lock, std::chrono::microseconds(1000000 / Freeze.rate), [] { return Freeze.stop; });
+		}
+	}
+}
+
+static void start_thread_locked() {
+	if (Freeze.running) return;
+	Freeze.stop = false;
+	Freeze.running = true;
+	Freeze.worker = std::thread(freeze_thread);
+}
+
+extern void freeze_setting(const Setting& s, GameValue value) {
+	SettingWrite w{};
+	w.address = s.m_address;
+	w.expected = s.m_setting;
+	w.value = value;
+
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	const auto found = std::lower_bound(
+		Freeze.entries.begin(),
+		Freeze.entries.end(),
+		w.address,
+		[](const SettingWrite& e, uintptr_t a) { return e.address < a; });
+
+	if ((found != Freeze.entries.end()) && (found->address == w.address)) {
+		found->value = value;
+	}
+	else {
+		Freeze.entries.insert(found, w);
+	}
+
+	++Freeze.generation;
+	Freeze.stats.frozen = (uint32_t)Freeze.entries.size();
+	start_thread_locked();
+	Freeze.wake.notify_one();
+}
+
+extern void unfreeze_setting(uintptr_t address) {
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	const auto found = std::lower_bound(
+		Freeze.entries.begin(),
+		Freeze.entries.end(),
+		address,
+		[](const SettingWrite& e, uintptr_t a) { return e.address < a; });
+
+	if ((found == Freeze.entries.end()) || (found->address != address)) return;
+	Freeze.entries.erase(found);
+	++Freeze.generation;
+	Freeze.stats.frozen = (uint32_t)Freeze.entries.size();
+}
+
+extern void unfreeze_all(void) {
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	Freeze.entries.clear();
+	++Freeze.generation;
+	Freeze.stats.frozen = 0;
+}
+
+extern bool is_setting_frozen(uintptr_t address) {
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	return std::binary_search(
+		Freeze.entries.begin(),
+		Freeze.entries.end(),
+		SettingWrite{ address },
+		[](const SettingWrite& a, const SettingWrite& b) { return a.address < b.address; });
+}
+
+extern void freeze_set_rate(unsigned hz) {
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	Freeze.rate = (hz < FREEZE_MIN_RATE) ? FREEZE_MIN_RATE : (hz > FREEZE_MAX_RATE) ? FREEZE_MAX_RATE : hz;
+	Freeze.wake.notify_one();
+}
+
+extern unsigned freeze_get_rate(void) {
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	return Freeze.rate;
+}
+
+extern FreezeStats freeze_stats(void) {
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	return Freeze.stats;
+}
+
+extern void freeze_shutdown(void) {
+	{
+		std::lock_guard<std::mutex> lock(Freeze.lock);
+		if (!Freeze.running) return;
+		Freeze.stop = true;
+		Freeze.entries.clear();
+		++Freeze.generation;
+		Freeze.wake.notify_one();
+	}
+
+	Freeze.worker.join();
+
+	std::lock_guard<std::mutex> lock(Freeze.lock);
+	Freeze.running = false;
+	Freeze.stats = FreezeStats{};
+	Freeze.total_reads = 0;
+	Freeze.total_writes = 0;
+	Freeze.total_cycle_us = 0;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "setting.h"
+
+//keeps selected settings pinned to a value from a background thread
+//every cycle reads all pinned settings in coalesced runs and writes back only the ones that drifted
+
+struct FreezeStats {
+	uint32_t frozen;            //settings currently pinned
+	uint64_t cycles;
+	uint64_t rewritten;         //drifted values that were restored
+	uint64_t dropped;           //settings unpinned because a guard check failed
+	double last_cycle_us;
+	double avg_cycle_us;
+	double reads_per_cycle;     //RPM calls
+	double writes_per_cycle;    //WPM calls
+	double cpu_percent;         //cpu time of the freeze thread as a percentage of one core
+};
+
+extern void freeze_setting(const Setting& s, GameValue value);
+extern void unfreeze_setting(uintptr_t address);
+extern void unfreeze_all(void);
+extern bool is_setting_frozen(uintptr_t address);
+
+extern void freeze_set_rate(unsigned hz);
+extern unsigned freeze_get_rate(void);
+extern FreezeStats freeze_stats(void);
+
+//stop the freeze thread, must be called before the process handle is closed
+extern void freeze_shutdown(void);
\ No newline at end of file
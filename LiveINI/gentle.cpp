@@ -0,0 +1,129 @@
+#include "gentle.h"
+#include "task_pool.h"
+
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+//reads smaller than this (a setting, a string, a pointer) use up budget but never wait for it
+static const uint64_t GENTLE_UNPACED_SIZE = (64 * 1024);
+//how often the frame time is sampled and the rate adjusted
+static const double GENTLE_SAMPLE_SECONDS = 0.1;
+
+static struct {
+	std::mutex lock;
+	std::atomic<bool> enabled;
+	GentleOptions options;
+	uint64_t piece;
+	double max_rate; //bytes per second
+	double rate;
+	double tokens; //negative while readers are sleeping off their reads
+	LARGE_INTEGER freq;
+	LARGE_INTEGER last_refill;
+	LARGE_INTEGER last_sample;
+	float baseline_ms;
+	GentleStats stats;
+} Gentle{};
+
+static double seconds_between(const LARGE_INTEGER& from, const LARGE_INTEGER& to) {
+	return (double)(to.QuadPart - from.QuadPart) / (double)Gentle.freq.QuadPart;
+}
+
+//additive increase while frames are fine, halve the rate when one is slow
+static void sample_frame_time(const LARGE_INTEGER& now) {
+	if (!Gentle.options.frame_time || !GameProcessInfo.process) return;
+	if (seconds_between(Gentle.last_sample, now) < GENTLE_SAMPLE_SECONDS) return;
+	Gentle.last_sample = now;
+
+	//read directly, the sample must not be paced itself
+	float value = 0;
+	SIZE_T bytes_read = 0;
+	if (!ReadProcessMemory(GameProcessInfo.process, (LPCVOID)Gentle.options.frame_time, &value, sizeof(value), &bytes_read)) return;
+	const float ms = (value < 1.0f) ? (value * 1000.0f) : value;
+	if (!(ms > 0.0f) || (ms > 1000.0f)) return;
+	Gentle.stats.frame_ms = ms;
+
+	const float target = (Gentle.options.target_ms > 0.0f) ? Gentle.options.target_ms : (Gentle.baseline_ms * 1.25f);
+	if (Gentle.baseline_ms && (ms > target)) {
+		Gentle.rate = std::max(Gentle.rate / 2, Gentle.max_rate / 64);
+		++Gentle.stats.backoffs;
+	}
+	else {
+		//only frames that are not slow move the baseline, a hitch must not raise it
+		Gentle.baseline_ms = Gentle.baseline_ms ? ((Gentle.baseline_ms * 0.95f) + (ms * 0.05f)) : ms;
+		Gentle.rate = std::min(Gentle.rate + (Gentle.max_rate / 20), Gentle.max_rate);
+	}
+	Gentle.stats.baseline_ms = Gentle.baseline_ms;
+	Gentle.stats.rate_mb = Gentle.rate / (1024 * 1024);
+}
+
+extern uint64_t gentle_acquire(uint64_t remaining) {
+	if (!Gentle.enabled) return remaining;
+
+	std::unique_lock<std::mutex> l(Gentle.lock);
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	sample_frame_time(now);
+
+	//at most one piece worth of budget builds up while nothing is read
+	Gentle.tokens = std::min(Gentle.tokens + (seconds_between(Gentle.last_refill, now) * Gentle.rate), (double)Gentle.piece);
+	Gentle.last_refill = now;
+
+	const auto size = std::min(remaining, Gentle.piece);
+	Gentle.tokens -= (double)size;
+	Gentle.stats.bytes += size;
+	if ((size < GENTLE_UNPACED_SIZE) || (Gentle.tokens >= 0)) return size;
+
+	//every reader waits out the debt in front of it, concurrent readers queue up behind each other
+	const double wait_ms = (-Gentle.tokens * 1000.0) / Gentle.rate;
+	Gentle.stats.waited_ms += wait_ms;
+	l.unlock();
+
+	Sleep((DWORD)std::ceil(wait_ms));
+	return size;
+}
+
+extern void gentle_update(void) {
+	if (!Gentle.enabled || !Gentle.options.frame_time) return;
+
+	std::lock_guard<std::mutex> l(Gentle.lock);
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	sample_frame_time(now);
+}
+
+extern void gentle_configure(const GentleOptions& options) {
+	{
+		std::lock_guard<std::mutex> l(Gentle.lock);
+		Gentle.options = options;
+		Gentle.piece = (uint64_t)(options.piece_kb ? options.piece_kb : 256) * 1024;
+		Gentle.max_rate = (double)std::max(options.rate_mb, 1u) * (1024 * 1024);
+		Gentle.rate = Gentle.max_rate;
+		Gentle.tokens = (double)Gentle.piece;
+		Gentle.baseline_ms = 0;
+		Gentle.stats = GentleStats{};
+		Gentle.stats.rate_mb = Gentle.rate / (1024 * 1024);
+		QueryPerformanceFrequency(&Gentle.freq);
+		QueryPerformanceCounter(&Gentle.last_refill);
+		Gentle.last_sample = Gentle.last_refill;
+		Gentle.enabled = options.enabled;
+	}
+
+	//the workers drop to the lowest priority and optionally move to the chosen cores, turning it off
+	//goes back to the worker threads setting as it is then
+	task_pool_restrict(options.enabled, options.enabled ? options.affinity : 0);
+
+	if (!options.enabled) Log("Gentle mode off");
+	else if (options.frame_time) Log("Gentle mode: up to %u MB/s in %llu KB reads, following the frame time at %p", options.rate_mb, Gentle.piece / 1024, options.frame_time);
+	else Log("Gentle mode: %u MB/s in %llu KB reads", options.rate_mb, Gentle.piece / 1024);
+}
+
+extern GentleOptions gentle_options(void) {
+	std::lock_guard<std::mutex> l(Gentle.lock);
+	return Gentle.options;
+}
+
+extern GentleStats gentle_stats(void) {
+	std::lock_guard<std::mutex> l(Gentle.lock);
+	return Gentle.stats;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "main.h"
+
+//gentle mode lets the scans run during gameplay without hitching the game
+//reads of the game's memory share a token bucket, large reads are paced in pieces and the workers drop to the lowest priority
+//with the address of the game's frame time the read rate backs off when frames get slow and recovers when they are back
+
+struct GentleOptions {
+	bool enabled;
+	uint32_t rate_mb;       //read budget in MB/s, the ceiling when adapting to frame times
+	uint32_t piece_kb;      //largest single read, 0 for 256
+	uint64_t affinity;      //cores the workers may run on, 0 keeps the worker threads setting
+	uintptr_t frame_time;   //address of a float the game stores its frame time in (seconds or ms), 0 for a fixed rate
+	float target_ms;        //slowest acceptable frame, 0 for 25% over the frame time measured so far
+};
+
+struct GentleStats {
+	uint64_t bytes;         //paced bytes read since gentle mode was enabled
+	double waited_ms;       //time readers spent waiting for the bucket
+	double rate_mb;         //current read rate
+	float frame_ms;         //last frame time sample, 0 without a frame time address
+	float baseline_ms;
+	unsigned backoffs;      //times the rate was halved
+};
+
+extern void gentle_configure(const GentleOptions& options);
+extern GentleOptions gentle_options(void);
+extern GentleStats gentle_stats(void);
+
+//called by RPM before each read, waits until the bucket allows it and returns how many of the remaining bytes to read now
+//returns remaining right away when gentle mode is off
+extern uint64_t gentle_acquire(uint64_t remaining);
+
+//sample the frame time, call about once per ui frame so the baseline follows the game while nothing is being read
+extern void gentle_update(void);
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "main.h"
 #include "heap_window.h"
 #include "process.h"
+#include "memory_scan.h"
+#include "large_pages.h"
+#include "scan_kernels.h"
+#include "task_pool.h"
 
 static std::vector<MemoryBlock> Heaps{};
 
@@ -30,31 +34,78 @@ void build_heap_list() {
 
 
 static std::vector<uintptr_t> ScanResults{};
-void scan_heap(const MemoryBlock heap, uintptr_t instance) {
-        static uintptr_t* ScanBuffer = NULL;
-        static const uint32_t ScanBufferSize = (60 * 1024 * 1024);
+static ResidencyStats ScanResidency{};
+void scan_heap(const MemoryBlock heap, uintptr_t instance, bool resident_only) {
+        static const uint32_t ScanChunkSize = (16 * 1024 * 1024);
 
         ScanResults.clear();
 
-        if (!ScanBuffer) {
-                ScanBuffer = (uintptr_t*) malloc(ScanBufferSize);
-                assert(ScanBuffer != NULL);
+        //pages outside the game's working set are not read, that would fault them back in
+        std::vector<MemoryBlock> runs{ heap };
+        if (resident_only) runs = GetResidentRuns(runs, &ScanResidency);
+        else ScanResidency = ResidencyStats{ (heap.size + 4095) / 4096, 0 };
+
+        //runs are split into chunks of at most 16MB and consecutive chunks grouped up to 16MB,
+        //so a heap of many short resident runs is not claimed and collected one run at a time
+        std::vector<MemoryBlock> chunks;
+        std::vector<size_t> groups; //first chunk of each group, then chunks.size()
+        uint64_t group_size = ScanChunkSize;
+        for (const auto& r : runs) {
+                for (uint64_t offset = 0; offset < r.size; offset += ScanChunkSize) {
+                        const auto size = std::min<uint64_t>(ScanChunkSize, r.size - offset);
+                        if (group_size + size > ScanChunkSize) {
+                                groups.push_back(chunks.size());
+                                group_size = 0;
+                        }
+                        group_size += size;
+                        chunks.push_back(MemoryBlock{ r.address + offset, size, r.flags });
+                }
         }
+        groups.push_back(chunks.size());
+        const auto group_count = groups.size() - 1;
+
+        //one task per worker with one buffer each, the tasks take groups until none are left
+        //so a task that can not allocate its buffer leaves its share to the others
+        const auto& kernels = scan_kernels();
+        std::vector<std::vector<uintptr_t>> parts(group_count);
+        std::atomic<size_t> next_group{ 0 };
+        std::atomic<unsigned> unreadable{ 0 };
+        const auto tasks = std::min<size_t>(task_pool_threads(), group_count);
+        parallel_for(tasks, 1, [&](size_t, size_t) {
+                const auto buffer = (uintptr_t*)large_alloc(ScanChunkSize);
+                if (!buffer) {
+                        Log("Heap scan: could not allocate a %uMB buffer, a worker sits this scan out", ScanChunkSize / (1024 * 1024));
+                        return;
+                }
 
-        uint64_t offset = 0;
-        do {
-                uint64_t scan_size = ((offset + ScanBufferSize) > heap.size) ? (heap.size - offset) : ScanBufferSize;
-                uint64_t count = scan_size / sizeof(ScanBuffer[0]);
-                if (!RPM(heap.address + offset, ScanBuffer, scan_size)) break;
-
-                for (uint64_t i = 0; i < count; ++i) {
-                        if (ScanBuffer[i] == instance) {
-                                ScanResults.push_back(heap.address + offset + (i * sizeof(ScanBuffer[0])));
+                for (size_t g = next_group++; g < group_count; g = next_group++) {
+                        auto& part = parts[g];
+                        for (size_t c = groups[g]; c < groups[g + 1]; ++c) {
+                                const auto address = chunks[c].address;
+                                const auto size = (size_t)(chunks[c].size / sizeof(uintptr_t));
+                                if (!RPM(address, buffer, size * sizeof(uintptr_t))) {
+                                        ++unreadable;
+                                        continue;
+                                }
+
+                                for (size_t i = 0; i < size; ++i) {
+                                        i += kernels.find_qword(buffer + i, size - i, instance);
+                                        if (i >= size) break;
+                                        part.push_back(address + (i * sizeof(uintptr_t)));
+                                }
                         }
                 }
+                large_free(buffer);
+        }, TaskPriority_High);
+
+        if (next_group < group_count) {
+                Log("Heap scan: no buffer could be allocated, %u of %u chunks not searched", (unsigned)(chunks.size() - groups[next_group]), (unsigned)chunks.size());
+        }
+        if (unreadable) Log("Heap scan: %u of %u chunks could not be read", unreadable.load(), (unsigned)chunks.size());
 
-                offset += scan_size;
-        } while (offset < heap.size);
+        for (const auto& part : parts) ScanResults.insert(ScanResults.end(), part.begin(), part.end());
+        Log("Heap scan: %u matches, %llu pages read, %llu paged out or never touched pages skipped",
+                (unsigned)ScanResults.size(), ScanResidency.resident_pages, ScanResidency.skipped_pages);
 }
 
 
@@ -63,6 +114,7 @@ void scan_heap(const MemoryBlock heap, uintptr_t instance) {
 
 extern void draw_heap_window() {
         static unsigned selected_heap = 0;
+        static bool resident_only = true;
 
         if (!GameProcessInfo.rtti_map.size()) {
                 ImGui::Text("Press Scan Starfield in the log window");
@@ -80,7 +132,12 @@ extern void draw_heap_window() {
         ImGui::SameLine();
         
         if (ImGui::Button("Scan")) {
-                scan_heap(Heaps[selected_heap], strtoull(search, NULL, 16));
+                scan_heap(Heaps[selected_heap], strtoull(search, NULL, 16), resident_only);
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Resident pages only", &resident_only);
+        if (ScanResidency.skipped_pages) {
+                ImGui::Text("Skipped %llu of %llu pages (paged out or never touched)", ScanResidency.skipped_pages, ScanResidency.resident_pages + ScanResidency.skipped_pages);
         }
 
         for (auto i = 0; i < Heaps.size(); ++i) {
@@ -100,8 +157,15 @@ extern void draw_heap_window() {
         clip.Begin((int)ScanResults.size());
         while (clip.Step()) {
                 for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
-                        char buffer[64];
-                        snprintf(buffer, sizeof(buffer), "%p", (void*)ScanResults[i]);
+                        char buffer[96];
+                        const auto offset = ScanResults[i] - GameProcessInfo.base_address;
+                        FunctionInfo fn;
+                        if ((ScanResults[i] >= GameProcessInfo.base_address) && (offset <= UINT32_MAX) && find_function((uint32_t)offset, &fn)) {
+                                snprintf(buffer, sizeof(buffer), "%p in starfield.exe+%x+0x%x", (void*)ScanResults[i], fn.entry, (uint32_t)offset - fn.entry);
+                        }
+                        else {
+                                snprintf(buffer, sizeof(buffer), "%p", (void*)ScanResults[i]);
+                        }
                         ImGui::PushID(i);
                         ImGui::InputText("Address", buffer, sizeof(buffer), ImGuiInputTextFlags_ReadOnly);
                         ImGui::PopID();
@@ -0,0 +1,93 @@
+#include "image_sections.h"
+#include "process.h"
+#include "insn_map.h"
+#include "text_index.h"
+
+static struct {
+	std::vector<ImageSection> sections;
+	bool text_required;
+} Image{};
+
+extern void image_sections_reset(void) {
+	Image.sections.clear();
+	Image.text_required = false;
+}
+
+extern const std::vector<ImageSection>& image_sections(void) {
+	return Image.sections;
+}
+
+extern void image_sections_build(void) {
+	image_sections_reset();
+
+	const auto buffer = (const char*)GameProcessInfo.buffer;
+	if (!buffer) return;
+
+	IMAGE_DOS_HEADER hdr;
+	IMAGE_NT_HEADERS64 nt;
+	memcpy(&hdr, buffer, sizeof(hdr));
+	memcpy(&nt, buffer + hdr.e_lfanew, sizeof(nt));
+	const auto sections = (const IMAGE_SECTION_HEADER*)(buffer + hdr.e_lfanew + offsetof(IMAGE_NT_HEADERS64, OptionalHeader) + nt.FileHeader.SizeOfOptionalHeader);
+
+	for (unsigned i = 0; i < nt.FileHeader.NumberOfSections; ++i) {
+		const auto& s = sections[i];
+		if (s.VirtualAddress >= GameProcessInfo.buffer_size) continue;
+
+		ImageSection is{};
+		memcpy(is.name, s.Name, sizeof(s.Name));
+		is.offset = s.VirtualAddress;
+		is.size = (uint32_t)std::min<uint64_t>((s.Misc.VirtualSize + 4095ULL) & ~4095ULL, GameProcessInfo.buffer_size - s.VirtualAddress);
+
+		//an attached module only shares its static sections with the file, a loaded exe file shares everything
+		const auto from_file = GameProcessInfo.buffer_mapped && (!GameProcessInfo.process || is_static_section(s));
+		is.source = from_file ? ImageSection_File : ImageSection_Process;
+		Image.sections.push_back(is);
+	}
+}
+
+extern void image_sections_update(void) {
+	const auto buffer = (char*)GameProcessInfo.buffer;
+	if (!buffer) return;
+
+	for (auto& s : Image.sections) {
+		const auto pages = s.size / 4096;
+		std::vector<PSAPI_WORKING_SET_EX_INFORMATION> info(pages);
+		for (uint32_t i = 0; i < pages; ++i) info[i].VirtualAddress = buffer + s.offset + (uint64_t)i * 4096;
+
+		s.resident = 0;
+		s.shared = 0;
+		if (pages && QueryWorkingSetEx(GetCurrentProcess(), info.data(), (DWORD)(pages * sizeof(info[0])))) {
+			for (const auto& x : info) {
+				if (!x.VirtualAttributes.Valid) continue;
+				s.resident += 4096;
+				if (x.VirtualAttributes.Shared) s.shared += 4096;
+			}
+		}
+
+		Log("%8.8s: %7.1fMB resident of %7.1fMB, %7.1fMB shared (%s)", s.name,
+			(double)s.resident / (1024.0 * 1024.0), (double)s.size / (1024.0 * 1024.0), (double)s.shared / (1024.0 * 1024.0),
+			(s.source == ImageSection_File) ? "exe file" : "process");
+	}
+}
+
+extern void image_section_evict(size_t index) {
+	if (!GameProcessInfo.buffer || !GameProcessInfo.buffer_mapped || (index >= Image.sections.size())) return;
+	const auto& s = Image.sections[index];
+
+	//unlocking pages that are not locked removes them from the working set
+	VirtualUnlock((char*)GameProcessInfo.buffer + s.offset, s.size);
+}
+
+extern void image_text_require(void) {
+	if (Image.text_required || !GameProcessInfo.buffer) return;
+	Image.text_required = true;
+
+	//one large read of the file instead of a page fault per page during the sweep
+	const auto& text = GameProcessInfo.exe.text;
+	WIN32_MEMORY_RANGE_ENTRY range{ (char*)GameProcessInfo.buffer + text.offset, text.size };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+
+	//both run on the pool, the tabs work without them until they are ready
+	insn_map_build_async();
+	text_index_build_async();
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "main.h"
+
+//section view of GameProcessInfo.buffer
+//file backed sections (see OpenGameProcess) are only paged in when touched and the os can drop them at any time,
+//attaching reads the .rdata pages the vtable scan walks and none of .text, the aob or method tab pages it in when needed
+
+enum ImageSectionSource : unsigned {
+	ImageSection_File,    //copy-on-write view of the exe file
+	ImageSection_Process, //private copy read from the process
+};
+
+struct ImageSection {
+	char name[9];
+	uint32_t offset;
+	uint32_t size;       //virtual size rounded up to pages
+	ImageSectionSource source;
+	uint64_t resident;   //bytes in the working set at the last image_sections_update
+	uint64_t shared;     //resident bytes that are shared with the file cache
+};
+
+//read the section table of the current image, call after perform_exe_section_analysis
+extern void image_sections_build(void);
+extern void image_sections_reset(void);
+extern const std::vector<ImageSection>& image_sections(void);
+
+//refresh the resident and shared bytes of every section with QueryWorkingSetEx and log them
+extern void image_sections_update(void);
+
+//remove a section from the working set, the next access reads it back from the file cache (or the page file)
+//does nothing for the full ReadProcessMemory copy (see OpenGameProcess), it is private and locked when on large pages
+extern void image_section_evict(size_t index);
+
+//first use of .text: prefetch it in one request and build the instruction map and text index, once per scan
+extern void image_text_require(void);
\ No newline at end of file
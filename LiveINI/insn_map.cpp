@@ -0,0 +1,163 @@
+#include "insn_map.h"
+#include "x86_decode.h"
+#include "task_pool.h"
+
+static struct {
+	TaskGroup worker;
+	std::atomic<bool> ready;
+	std::vector<uint64_t> bits;
+	uint32_t text_offset;
+	uint32_t text_size;
+	InsnMapStats stats;
+} Map{};
+
+//the first function entry at or after the image offset pos, or end
+//.pdata is used when present, otherwise a 16 byte aligned entry after int3 padding
+static uint32_t next_function(uint32_t pos, uint32_t end) {
+	const auto& ft = GameProcessInfo.exe.functions;
+	if (!ft.begin.empty()) {
+		const auto it = std::lower_bound(ft.begin.begin(), ft.begin.end(), pos);
+		return ((it == ft.begin.end()) || (*it >= end)) ? end : *it;
+	}
+
+	const auto image = (const uint8_t*)GameProcessInfo.buffer;
+	for (pos = (pos + 15) & ~15u; pos + 16 < end; pos += 16) {
+		if ((image[pos - 1] == 0xCC) && (image[pos] != 0xCC) && ((image[pos - 2] == 0xCC) || (image[pos - 2] == 0xC3))) {
+			return pos;
+		}
+	}
+	return end;
+}
+
+struct SweepResult {
+	uint64_t instructions;
+	uint64_t invalid;
+	uint64_t first_word; //bits of the words shared with the neighbouring ranges
+	uint64_t last_word;
+};
+
+static void sweep(const uint8_t* text, uint32_t begin, uint32_t end, SweepResult* out) {
+	const auto first = begin / 64;
+	const auto last = (end - 1) / 64;
+	auto bits = Map.bits.data();
+
+	uint32_t pos = begin;
+	while (pos < end) {
+		const auto word = pos / 64;
+		const auto bit = 1ULL << (pos % 64);
+		if (word == first) out->first_word |= bit;
+		else if (word == last) out->last_word |= bit;
+		else bits[word] |= bit;
+
+		X86Insn insn;
+		if (x86_decode(text + pos, Map.text_size - pos, &insn)) {
+			++out->instructions;
+			pos += insn.length;
+		}
+		else {
+			//not code, or a form the decoder does not know, resync on the next byte
+			++out->invalid;
+			++pos;
+		}
+	}
+}
+
+extern void insn_map_reset(void) {
+	//the sweep is not cancelled, it takes a fraction of a second
+	task_wait(Map.worker);
+
+	Map.ready = false;
+	Map.bits = std::vector<uint64_t>{};
+	Map.text_offset = 0;
+	Map.text_size = 0;
+	Map.stats = InsnMapStats{};
+}
+
+//fills Map after a reset, the lookups are only used once ready is set at the end
+static void build(void) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	const auto& t = GameProcessInfo.exe.text;
+	if (!GameProcessInfo.buffer || !t.size || ((uint64_t)t.offset + t.size > GameProcessInfo.buffer_size)) {
+		Log("insn_map_build: no .text section");
+		return;
+	}
+
+	const auto text = (const uint8_t*)GameProcessInfo.buffer + t.offset;
+	Map.text_offset = t.offset;
+	Map.text_size = t.size;
+	Map.bits.resize((t.size + 63) / 64);
+
+	const unsigned workers = task_pool_threads();
+
+	//cut the section into ranges of whole functions, roughly equal in size
+	std::vector<uint32_t> cuts{ 0 };
+	for (unsigned i = 1; i < workers; ++i) {
+		const auto target = t.offset + (uint32_t)((uint64_t)t.size * i / workers);
+		if (target <= t.offset + cuts.back()) continue;
+		const auto cut = next_function(target, t.offset + t.size);
+		if (cut < t.offset + t.size) cuts.push_back(cut - t.offset);
+	}
+	cuts.push_back(t.size);
+
+	const auto count = cuts.size() - 1;
+	std::vector<SweepResult> results(count, SweepResult{});
+	parallel_for(count, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) sweep(text, cuts[i], cuts[i + 1], &results[i]);
+	});
+
+	for (size_t i = 0; i < count; ++i) {
+		const auto& r = results[i];
+		Map.bits[cuts[i] / 64] |= r.first_word;
+		Map.bits[(cuts[i + 1] - 1) / 64] |= r.last_word;
+		Map.stats.instructions += r.instructions;
+		Map.stats.invalid += r.invalid;
+	}
+
+	QueryPerformanceCounter(&end);
+	Map.stats.threads = (unsigned)count;
+	Map.stats.elapsed_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+	Map.stats.mb_per_s = (Map.stats.elapsed_ms > 0) ? ((double)t.size / (1024.0 * 1024.0)) / (Map.stats.elapsed_ms / 1000.0) : 0;
+
+	Log("Instruction map: %llu instructions, %llu invalid bytes, %u threads, %.0fms (%.0f MB/s)",
+		Map.stats.instructions, Map.stats.invalid, Map.stats.threads, Map.stats.elapsed_ms, Map.stats.mb_per_s);
+	Map.ready = true;
+}
+
+extern void insn_map_build(void) {
+	insn_map_reset();
+	build();
+}
+
+extern void insn_map_build_async(void) {
+	insn_map_reset();
+	task_submit(build, &Map.worker);
+}
+
+extern bool insn_map_ready(void) {
+	return Map.ready;
+}
+
+extern bool insn_map_building(void) {
+	return Map.worker.pending != 0;
+}
+
+extern InsnMapStats insn_map_stats(void) {
+	return Map.stats;
+}
+
+extern bool is_instruction_start(uint32_t offset) {
+	if ((offset < Map.text_offset) || (offset - Map.text_offset >= Map.text_size)) return false;
+	const auto pos = offset - Map.text_offset;
+	return (Map.bits[pos / 64] >> (pos % 64)) & 1;
+}
+
+extern void insn_map_filter(std::vector<uint32_t>& offsets) {
+	auto out = offsets.begin();
+	for (const auto x : offsets) {
+		if (is_instruction_start(x)) *out++ = x;
+	}
+	offsets.erase(out, offsets.end());
+}
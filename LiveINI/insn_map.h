@@ -0,0 +1,32 @@
+#pragma once
+
+#include "main.h"
+
+//one bit per .text byte marking where a linear sweep of x86_decode starts an instruction
+//the sweep is split at function entries (.pdata, or int3 padding without it) so every thread starts on an instruction
+
+struct InsnMapStats {
+	uint64_t instructions;
+	uint64_t invalid;     //bytes skipped because they did not decode
+	unsigned threads;
+	double elapsed_ms;
+	double mb_per_s;
+};
+
+//sweep the current .text, replaces any previous map
+extern void insn_map_build(void);
+//same as a task on the pool, insn_map_ready turns true when it is done
+extern void insn_map_build_async(void);
+//waits for a running build
+extern void insn_map_reset(void);
+
+//the lookups below may only be used once this is true
+extern bool insn_map_ready(void);
+extern bool insn_map_building(void);
+extern InsnMapStats insn_map_stats(void);
+
+//offset is relative to the image base, false outside .text or before the map is built
+extern bool is_instruction_start(uint32_t offset);
+
+//remove every offset that is not an instruction start, keeps the order
+extern void insn_map_filter(std::vector<uint32_t>& offsets);
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "large_pages.h"
+#include "aobscan.h"
+
+#include <mutex>
+
+static struct {
+	std::once_flag init;
+	SIZE_T minimum; //0 if large pages can not be used
+} LargePages{};
+
+//large pages need SeLockMemoryPrivilege enabled in the token, it is granted by policy but off by default
+static bool enable_lock_memory_privilege() {
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+
+	TOKEN_PRIVILEGES tp{};
+	tp.PrivilegeCount = 1;
+	tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	bool ok = LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &tp.Privileges[0].Luid) &&
+		AdjustTokenPrivileges(token, FALSE, &tp, 0, NULL, NULL) &&
+		(GetLastError() == ERROR_SUCCESS); //ERROR_NOT_ALL_ASSIGNED if the account does not hold it
+
+	CloseHandle(token);
+	return ok;
+}
+
+static void init_large_pages() {
+	const auto minimum = GetLargePageMinimum();
+	if (!minimum) {
+		Log("Large pages: not supported, using 4KB pages");
+		return;
+	}
+	if (!enable_lock_memory_privilege()) {
+		Log("Large pages: SeLockMemoryPrivilege is not held, using 4KB pages");
+		return;
+	}
+	LargePages.minimum = minimum;
+	Log("Large pages: enabled (%uKB)", (unsigned)(minimum / 1024));
+}
+
+extern bool large_pages_available(void) {
+	std::call_once(LargePages.init, init_large_pages);
+	return (LargePages.minimum != 0);
+}
+
+//null if large pages are unavailable or the os has no contiguous physical memory left
+static void* alloc_large_pages(size_t size) {
+	if (!large_pages_available() || (size < LargePages.minimum)) return NULL;
+	const auto rounded = (size + LargePages.minimum - 1) & ~(LargePages.minimum - 1);
+	return VirtualAlloc(NULL, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+}
+
+static void* alloc_small_pages(size_t size) {
+	return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+extern void* large_alloc(size_t size) {
+	if (!size) return NULL;
+	const auto buffer = alloc_large_pages(size);
+	return buffer ? buffer : alloc_small_pages(size);
+}
+
+extern void large_free(void* buffer) {
+	if (buffer) VirtualFree(buffer, 0, MEM_RELEASE);
+}
+
+
+struct BenchmarkResult {
+	double fill_ms;      //first touch of every page
+	double qword_ms;     //scan_heap kernel: compare every qword against a pointer
+	double aob_ms;       //aob_scan over the whole buffer
+	double random_ns;    //dependent random qword loads, one tlb lookup each
+	uint64_t checksum;   //keeps the loops from being optimized out
+};
+
+static double elapsed_ms(const LARGE_INTEGER& start, const LARGE_INTEGER& freq) {
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return (double)(now.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+}
+
+static void run_benchmark(uint64_t* buffer, uint64_t size, AOB_SIG sig, BenchmarkResult& r) {
+	constexpr uint64_t random_loads = 16 * 1024 * 1024;
+	const auto count = size / sizeof(buffer[0]);
+
+	LARGE_INTEGER freq, start;
+	QueryPerformanceFrequency(&freq);
+
+	//same xorshift sequence for both buffers
+	QueryPerformanceCounter(&start);
+	uint64_t x = 0x9E3779B97F4A7C15ULL;
+	for (uint64_t i = 0; i < count; ++i) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		buffer[i] = x;
+	}
+	r.fill_ms = elapsed_ms(start, freq);
+
+	QueryPerformanceCounter(&start);
+	const auto needle = buffer[count / 2];
+	uint64_t hits = 0;
+	for (uint64_t i = 0; i < count; ++i) {
+		if (buffer[i] == needle) ++hits;
+	}
+	r.qword_ms = elapsed_ms(start, freq);
+
+	QueryPerformanceCounter(&start);
+	const auto aob_size = (unsigned)std::min<uint64_t>(size, 0xFFFFF000ULL);
+	unsigned offset = 0;
+	while ((offset = aob_scan(buffer, aob_size, offset, sig)) != AOB_NO_MATCH) {
+		++hits;
+		++offset;
+	}
+	r.aob_ms = elapsed_ms(start, freq);
+
+	QueryPerformanceCounter(&start);
+	uint64_t index = 0;
+	for (uint64_t i = 0; i < random_loads; ++i) {
+		index = buffer[index] % count;
+	}
+	r.random_ns = elapsed_ms(start, freq) * 1000000.0 / (double)random_loads;
+
+	r.checksum = hits + index;
+}
+
+static void log_result(const char* name, uint64_t size, const BenchmarkResult& r) {
+	const auto gb = (double)size / (1024.0 * 1024.0 * 1024.0);
+	Log("%s: fill %7.1fms, qword scan %6.2fGB/s, aob scan %6.2fGB/s, random load %6.1fns (%llu)", name,
+		r.fill_ms, gb * 1000.0 / r.qword_ms, gb * 1000.0 / r.aob_ms, r.random_ns, r.checksum);
+}
+
+extern void large_pages_benchmark(uint64_t size) {
+	size &= ~4095ULL;
+	if (!size) return;
+
+	const auto sig = aob_compile("48 8B 05 ?? ?? ?? ?? 48 85 C0");
+	Log("Large page benchmark: %.0fMB", (double)size / (1024.0 * 1024.0));
+
+	BenchmarkResult small{}, large{};
+	const auto small_buffer = (uint64_t*)alloc_small_pages((size_t)size);
+	if (small_buffer) {
+		run_benchmark(small_buffer, size, sig, small);
+		large_free(small_buffer);
+		log_result("   4KB pages", size, small);
+	}
+
+	const auto large_buffer = (uint64_t*)alloc_large_pages((size_t)size);
+	if (large_buffer) {
+		run_benchmark(large_buffer, size, sig, large);
+		large_free(large_buffer);
+		log_result("Large pages", size, large);
+	}
+	else {
+		Log("Could not allocate %.0fMB of large pages", (double)size / (1024.0 * 1024.0));
+	}
+
+	if (small_buffer && large_buffer) {
+		Log("Speedup: qword scan %.2fx, aob scan %.2fx, random load %.2fx",
+			small.qword_ms / large.qword_ms, small.aob_ms / large.aob_ms, small.random_ns / large.random_ns);
+	}
+	aob_free(sig);
+}
\ No newline at end of file
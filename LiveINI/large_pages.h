@@ -0,0 +1,19 @@
+#pragma once
+
+#include "main.h"
+
+//page aligned buffers for the scans that stream through hundreds of MB (image buffer, heap and value scans)
+//uses 2MB large pages when the account holds SeLockMemoryPrivilege ("Lock pages in memory"), 4KB pages otherwise
+//large pages are never paged out, so they are only used for buffers of at least one large page
+
+//allocate size bytes of zeroed memory, returns null if even the 4KB fallback fails
+extern void* large_alloc(size_t size);
+
+//free memory from large_alloc, null is ignored
+extern void large_free(void* buffer);
+
+//true if large_alloc can hand out large pages (the privilege was enabled)
+extern bool large_pages_available(void);
+
+//compare the scan kernels on large and 4KB pages over a buffer of size bytes, results go to the log
+extern void large_pages_benchmark(uint64_t size);
\ No newline at end of file
@@ -1,10 +1,26 @@
 #include "main.h"
 
+#include <mutex>
+
 static ImGuiTextBuffer log_buff{};
+static std::mutex log_lock{}; //background workers log too
+static bool log_stderr{ false };
+
+extern void log_to_stderr(bool enable) {
+	std::lock_guard<std::mutex> lock(log_lock);
+	log_stderr = enable;
+}
 
 extern void Log(const char* const fmt, ...) {
+	std::lock_guard<std::mutex> lock(log_lock);
 	va_list args;
 	va_start(args, fmt);
+	if (log_stderr) {
+		vfprintf(stderr, fmt, args);
+		fputc('\n', stderr);
+		va_end(args);
+		return;
+	}
 	log_buff.appendfv(fmt, args);
 	log_buff.append("\n");
 	va_end(args);
@@ -15,6 +31,7 @@ extern void draw_log_window(void) {
 
 	ImGui::Checkbox("AutoScroll", &log_scroll);
 	ImGui::SameLine();
+	std::lock_guard<std::mutex> lock(log_lock);
 	if (ImGui::Button("Clear")) {
 		log_buff.clear();
 	}
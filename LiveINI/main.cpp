@@ -6,6 +6,20 @@
 #include "aob_window.h"
 #include "method_window.h"
 #include "heap_window.h"
+#include "snapshot_window.h"
+#include "value_window.h"
+#include "value_scan.h"
+#include "diff_window.h"
+#include "cli.h"
+#include "text_index.h"
+#include "insn_map.h"
+#include "method_index.h"
+#include "class_hierarchy.h"
+#include "analysis_cache.h"
+#include "rtti_names.h"
+#include "image_sections.h"
+#include "task_pool.h"
+#include "gentle.h"
 
 // Init global data
 extern ProcessInfo GameProcessInfo = { nullptr };
@@ -24,52 +38,6 @@ void CleanupRenderTarget();
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 
-static bool ScanProcess(DWORD procid) {
-        if (!procid) {
-                Log("procid is 0, no process selected");
-                return false;
-        }
-
-        if (GameProcessInfo.process) {
-                CloseHandle(GameProcessInfo.process);
-                _aligned_free(GameProcessInfo.buffer);
-                GameProcessInfo.rtti_map.clear();
-        }
-
-        Log("Scan Process ID: %u", procid);
-
-        const auto proc_handle = OpenProcess(PROCESS_ALL_ACCESS, FALSE, procid);
-        if (!proc_handle) {
-                Log("Could not open process");
-                return false;
-        }
-
-        const auto mb = GetProcessBlock(proc_handle);
-        if (!mb.address) {
-                Log("Could not get process block!");
-                return false;
-        }
-
-        const auto buffer = _aligned_malloc((mb.size + 4095) & (~4095ULL), 4096);
-        if (!buffer) {
-                Log("Could not allocate memory for process buffer");
-                return false;
-        }
-
-        GameProcessInfo.proc_id = procid;
-        GameProcessInfo.process = proc_handle;
-        GameProcessInfo.base_address = mb.address;
-        GameProcessInfo.buffer_size = mb.size;
-        GameProcessInfo.buffer = buffer;
-
-        if (!RPM(mb.address, buffer, mb.size)) {
-                Log("Could not read process memory");
-                return false;
-        }
-        
-        return true;
-}
-
 static void ScanGame() {
         static char target[64] = "Starfield";
         static bool specify_target = false;
@@ -91,10 +59,15 @@ static void ScanGame() {
 
                         // the operations below must be performed in this exact order
                         // each operation builds more info about the exe and is used by the next operation
-                        if (ScanProcess(proc)) {
+                        if (OpenGameProcess(proc)) {
                                 perform_exe_section_analysis();
                                 perform_exe_version_analysis();
                                 turbo_vtable_algorithm();
+                                method_index_build();
+                                if (!analysis_cache_install_hierarchy()) class_hierarchy_build();
+                                rtti_names_build();
+                                image_sections_build();
+                                image_sections_update();
 
                                 if (!ImGui::IsKeyDown(ImGuiKey_LeftCtrl)) {
                                         scan_vtable();
@@ -105,12 +78,83 @@ static void ScanGame() {
         if (specify_target) {
                 ImGui::InputText("Target", target, sizeof(target));
         }
+        if (GameProcessInfo.buffer) {
+                if (ImGui::Button("Image Memory")) {
+                        image_sections_update();
+                }
+                //the full ReadProcessMemory copy is private and, with large pages, locked, trimming it does nothing
+                if (!GameProcessInfo.buffer_mapped) {
+                        ImGui::SameLine();
+                        ImGui::TextUnformatted("Image is a private copy, not mapped from the exe file, it can not be trimmed");
+                }
+                else if (ImGui::Button("Trim Image")) {
+                        for (size_t i = 0; i < image_sections().size(); ++i) {
+                                image_section_evict(i);
+                        }
+                        image_sections_update();
+                }
+        }
+        if (ImGui::CollapsingHeader("Worker Threads")) {
+                //fewer threads or a core mask that leaves the game's cores alone keeps the scans from stuttering the game
+                static int threads = 0;
+                static char affinity[20];
+                ImGui::InputInt("Threads (0 = one per core)", &threads);
+                ImGui::InputText("Cores (hex mask, empty = all)", affinity, sizeof(affinity), ImGuiInputTextFlags_CharsHexadecimal);
+                if (ImGui::Button("Apply")) {
+                        auto options = task_pool_options();
+                        options.threads = (unsigned)std::max(threads, 0);
+                        options.affinity = _strtoui64(affinity, NULL, 16);
+                        task_pool_configure(options);
+                }
+                ImGui::SameLine();
+                ImGui::Text("%u threads", task_pool_threads());
+        }
+
+        gentle_update();
+        if (ImGui::CollapsingHeader("Gentle Scanning")) {
+                //paces the reads of the game's memory so scans can run during gameplay
+                //the frame time address can be found with the value scanner, the game's frame delta is a float in seconds
+                static bool enabled = false;
+                static int rate_mb = 128;
+                static int piece_kb = 256;
+                static char cores[20];
+                static char frame_time[20];
+                static float target_ms = 0;
+                ImGui::Checkbox("Enabled", &enabled);
+                ImGui::InputInt("Read rate (MB/s)", &rate_mb);
+                ImGui::InputInt("Read size (KB)", &piece_kb);
+                ImGui::InputText("Scan cores (hex mask, empty = unchanged)", cores, sizeof(cores), ImGuiInputTextFlags_CharsHexadecimal);
+                ImGui::InputText("Frame time address", frame_time, sizeof(frame_time), ImGuiInputTextFlags_CharsHexadecimal);
+                ImGui::InputFloat("Target frame time (ms, 0 = auto)", &target_ms);
+                if (ImGui::Button("Apply##gentle")) {
+                        GentleOptions options{};
+                        options.enabled = enabled;
+                        options.rate_mb = (uint32_t)std::max(rate_mb, 1);
+                        options.piece_kb = (uint32_t)std::max(piece_kb, 4);
+                        options.affinity = _strtoui64(cores, NULL, 16);
+                        options.frame_time = (uintptr_t)_strtoui64(frame_time, NULL, 16);
+                        options.target_ms = std::max(target_ms, 0.0f);
+                        gentle_configure(options);
+                }
+                if (gentle_options().enabled) {
+                        const auto stats = gentle_stats();
+                        ImGui::Text("%.1f MB/s, %.1f MB read, %.0f ms waited", stats.rate_mb, stats.bytes / (1024.0 * 1024.0), stats.waited_ms);
+                        if (stats.frame_ms) {
+                                ImGui::Text("Frame %.2f ms (baseline %.2f ms), backed off %u times", stats.frame_ms, stats.baseline_ms, stats.backoffs);
+                        }
+                }
+        }
 }
 
 
 // Main code
 int WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 {
+        // Command line arguments select the headless front-end, no window or d3d device is created
+        if (cli_requested(__argc, __argv)) {
+                return cli_main(__argc, __argv);
+        }
+
         // Create application window
         //ImGui_ImplWin32_EnableDpiAwareness();
         WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(NULL), NULL, NULL, NULL, NULL, "ImGui Example", NULL };
@@ -202,6 +246,21 @@ int WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
                                         draw_heap_window();
                                         ImGui::EndTabItem();
                                 }
+                                if (ImGui::BeginTabItem("Snapshot")) {
+                                        draw_snapshot_window();
+                                        ImGui::EndTabItem();
+                                }
+                                if (ImGui::BeginTabItem("Value")) {
+                                        draw_value_window();
+                                        ImGui::EndTabItem();
+                                }
+                                else {
+                                        value_scan_release();
+                                }
+                                if (ImGui::BeginTabItem("Diff")) {
+                                        draw_diff_window();
+                                        ImGui::EndTabItem();
+                                }
                                 ImGui::EndTabBar();
                         }
                 }
@@ -219,6 +278,7 @@ int WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         }
 
         // Cleanup
+        CloseGameProcess();
         ImGui_ImplDX11_Shutdown();
         ImGui_ImplWin32_Shutdown();
         ImGui::DestroyContext();
@@ -61,6 +61,7 @@
 //log functions from log_window.cpp
 extern void Log(const char* const fmt, ...);
 extern void draw_log_window(void);
+extern void log_to_stderr(bool enable); //headless mode, log lines go to stderr instead of the log window
 
 
 enum MemoryFlag : unsigned {
@@ -86,6 +87,7 @@ struct RTTI_Info {
 struct ProcessInfo {
 	HANDLE process;
 	void* buffer;
+	bool buffer_mapped; //buffer is a view of an exe file (LoadExeFile) instead of large_alloc memory
 	uint64_t buffer_size;
 	uint64_t base_address;
 	DWORD proc_id;
@@ -104,6 +106,17 @@ struct ProcessInfo {
 			unsigned build;
 			unsigned revision;
 		} version;
+
+		//.pdata function ranges sorted by begin, as parallel arrays so the binary search only touches begin
+		//entry is the primary function of a range, chained (split or cold) ranges point back to it
+		struct FunctionTable {
+			std::vector<uint32_t> begin;
+			std::vector<uint32_t> end;
+			std::vector<uint32_t> entry;
+		} functions;
+
+		//image offsets of every absolute pointer in the image (IMAGE_REL_BASED_DIR64 entries of .reloc), sorted
+		std::vector<uint32_t> pointer_slots;
 	} exe;
 
 	std::vector<MemoryBlock> blocks;
@@ -1,7 +1,13 @@
 #include "main.h"
+#include "memory_scan.h"
 #include "process.h"
 #include "setting.h"
 #include "aobscan.h"
+#include "freeze.h"
+#include "setting_export.h"
+#include "profile.h"
+#include "scan_kernels.h"
+#include "task_pool.h"
 
 extern "C" {
 	#include "minilibs/regexp.h"
@@ -35,26 +41,18 @@ public:
 };
 
 
-template<typename T>
-static uintptr_t find(const Pointer haystack, const Pointer endptr, uint64_t * const offset, const T needle) {
-	const Pointer start(haystack + *offset);
-	if (start >= endptr) return 0;
-	const auto b = start.as<const T*>();
-	const auto count = ((endptr - start) / sizeof(T)).as<unsigned>();
-	for (unsigned i = 0; i < count; ++i) {
-		if (b[i] == needle) {
-			*offset += (i * sizeof(T));
-			return *offset;
-		}
-	}
-	return 0;
-}
-
 //should cache result?
+static void build_function_table(ProcessInfo& p, uint32_t pdata_offset, uint32_t pdata_size);
+static void build_pointer_slots(ProcessInfo& p, uint32_t reloc_offset, uint32_t reloc_size);
+
 extern void perform_exe_section_analysis() {
-	assert(GameProcessInfo.buffer != NULL);
-	assert(GameProcessInfo.buffer_size != 0);
-	const Pointer haystack{ GameProcessInfo.buffer };
+	perform_exe_section_analysis(GameProcessInfo);
+}
+
+extern void perform_exe_section_analysis(ProcessInfo& p) {
+	assert(p.buffer != NULL);
+	assert(p.buffer_size != 0);
+	const Pointer haystack{ p.buffer };
 
 	IMAGE_DOS_HEADER hdr;
 	memcpy(&hdr, haystack.as<const void*>(), sizeof(hdr));
@@ -69,16 +67,16 @@ extern void perform_exe_section_analysis() {
 		const auto &s = sections[i];
 			
 		if (memcmp(".text", s.Name, sizeof(".text") - 1) == 0) {
-			GameProcessInfo.exe.text = { s.VirtualAddress, s.SizeOfRawData };
+			p.exe.text = { s.VirtualAddress, s.SizeOfRawData };
 		}
 		else if (memcmp(".rdata", s.Name, sizeof(".rdata") - 1) == 0) {
-			GameProcessInfo.exe.rdata = { s.VirtualAddress, s.SizeOfRawData };
+			p.exe.rdata = { s.VirtualAddress, s.SizeOfRawData };
 		}
 		else if (memcmp(".data", s.Name, sizeof(".data") - 1) == 0) {
-			GameProcessInfo.exe.data = { s.VirtualAddress, s.SizeOfRawData };
+			p.exe.data = { s.VirtualAddress, s.SizeOfRawData };
 		}
 		else if (memcmp(".rsrc", s.Name, sizeof(".rsrc") - 1) == 0) {
-			GameProcessInfo.exe.rsrc = { s.VirtualAddress, s.SizeOfRawData };
+			p.exe.rsrc = { s.VirtualAddress, s.SizeOfRawData };
 		}
 		else {
 			continue;
@@ -87,70 +85,303 @@ extern void perform_exe_section_analysis() {
 		Log("%8.8s: %8X - %8X", s.Name, s.VirtualAddress, (s.VirtualAddress + s.SizeOfRawData));
 	}
 
+	const auto& dir = hdr2.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+	build_function_table(p, dir.VirtualAddress, dir.Size);
+
+	const auto& reloc = hdr2.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+	build_pointer_slots(p, reloc.VirtualAddress, reloc.Size);
 }
 
-extern void turbo_vtable_algorithm() {
-	// Utilize the 2 step turbo vtable algorithm to automagically resolve
-	// an rtti mangled name into the corresponding vtable pointer
-	// no, there are no google results for "turbo vtable algorithm" yet
+//the unwind info of a chained range ends with the RUNTIME_FUNCTION of its parent
+static constexpr uint8_t UNW_FLAG_CHAININFO = 0x4;
+static constexpr unsigned MAX_CHAIN_DEPTH = 32;
 
-	const auto text_start = GameProcessInfo.base_address + GameProcessInfo.exe.text.offset;
-	const auto text_end = text_start + GameProcessInfo.exe.text.size;
-#define is_text_ptr(PTR) (((PTR) >= text_start) && ((PTR) <= text_end))
+static uint32_t resolve_chained_entry(const ProcessInfo& p, const RUNTIME_FUNCTION& rf) {
+	const auto buffer = (const uint8_t*)p.buffer;
+	const auto size = p.buffer_size;
 
-	const auto rdata_start = GameProcessInfo.base_address + GameProcessInfo.exe.rdata.offset;
-	const auto rdata_end = rdata_start + GameProcessInfo.exe.rdata.size;
-#define is_rdata_ptr(PTR) (((PTR) >= rdata_start) && ((PTR) <= rdata_end))
+	RUNTIME_FUNCTION cur = rf;
+	for (unsigned depth = 0; depth < MAX_CHAIN_DEPTH; ++depth) {
+		const auto info = cur.UnwindData;
+		if ((uint64_t)info + 4 > size) break;
 
-	const auto data_start = GameProcessInfo.exe.data.offset;
-	const auto data_end = data_start + GameProcessInfo.exe.data.size;
-#define is_data_offset(OFF) (((OFF) >= data_start) && ((OFF) <= data_end))
+		const auto flags = buffer[info] >> 3;
+		if (!(flags & UNW_FLAG_CHAININFO)) break;
 
+		//unwind codes are 2 bytes each, padded to an even count
+		const uint32_t codes = buffer[info + 2];
+		const uint64_t parent = (uint64_t)info + 4 + ((codes + 1) & ~1u) * 2;
+		if (parent + sizeof(RUNTIME_FUNCTION) > size) break;
+		memcpy(&cur, buffer + parent, sizeof(cur));
+	}
+	return cur.BeginAddress;
+}
 
-	const uint64_t* haystack = (uint64_t*)((char*)GameProcessInfo.buffer + GameProcessInfo.exe.rdata.offset);
-	const uint32_t count = GameProcessInfo.exe.rdata.size / sizeof(*haystack);
-	const uint32_t rdata_offset = GameProcessInfo.exe.rdata.offset;
-	const uint64_t base = GameProcessInfo.base_address;
+static void build_function_table(ProcessInfo& p, uint32_t pdata_offset, uint32_t pdata_size) {
+	auto& ft = p.exe.functions;
+	ft = ProcessInfo::ExeInfo::FunctionTable{};
 
-	struct Candidate {
-		uint32_t vtable_offset;
-		uint32_t object_locator_offset;
-		uint32_t func_count;
-	};
-	std::vector<Candidate> Candidates;
-	Candidates.reserve(32768);
+	if (!pdata_offset || ((uint64_t)pdata_offset + pdata_size > p.buffer_size)) {
+		Log("No exception directory, function lookup is disabled");
+		return;
+	}
+
+	const auto entries = (const RUNTIME_FUNCTION*)((const char*)p.buffer + pdata_offset);
+	const auto count = pdata_size / sizeof(RUNTIME_FUNCTION);
+
+	ft.begin.reserve(count);
+	ft.end.reserve(count);
+	ft.entry.reserve(count);
+
+	//the loader requires .pdata to be sorted, but check instead of trusting it
+	bool sorted = true;
+	for (size_t i = 0; i < count; ++i) {
+		const auto& rf = entries[i];
+		if (!rf.BeginAddress || (rf.EndAddress <= rf.BeginAddress)) continue;
+		if (!ft.begin.empty() && (rf.BeginAddress < ft.begin.back())) sorted = false;
+
+		ft.begin.push_back(rf.BeginAddress);
+		ft.end.push_back(rf.EndAddress);
+		ft.entry.push_back(resolve_chained_entry(p, rf));
+	}
+
+	if (!sorted) {
+		std::vector<uint32_t> order(ft.begin.size());
+		for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return ft.begin[a] < ft.begin[b]; });
+
+		ProcessInfo::ExeInfo::FunctionTable tmp;
+		tmp.begin.reserve(order.size());
+		tmp.end.reserve(order.size());
+		tmp.entry.reserve(order.size());
+		for (const auto i : order) {
+			tmp.begin.push_back(ft.begin[i]);
+			tmp.end.push_back(ft.end[i]);
+			tmp.entry.push_back(ft.entry[i]);
+		}
+		ft = std::move(tmp);
+	}
+
+	size_t chained = 0;
+	for (size_t i = 0; i < ft.begin.size(); ++i) chained += (ft.entry[i] != ft.begin[i]);
+	Log("   .pdata: %u functions (%u chained ranges)", (unsigned)ft.begin.size(), (unsigned)chained);
+}
+
+extern bool find_function(uint32_t offset, FunctionInfo* out) {
+	const auto& ft = GameProcessInfo.exe.functions;
+
+	//last range starting at or before offset
+	const auto it = std::upper_bound(ft.begin.begin(), ft.begin.end(), offset);
+	if (it == ft.begin.begin()) return false;
+
+	const auto i = (it - ft.begin.begin()) - 1;
+	if (offset >= ft.end[i]) return false;
+
+	out->begin = ft.begin[i];
+	out->end = ft.end[i];
+	out->entry = ft.entry[i];
+	return true;
+}
+
+static void build_pointer_slots(ProcessInfo& p, uint32_t reloc_offset, uint32_t reloc_size) {
+	auto& slots = p.exe.pointer_slots;
+	slots.clear();
 
-	//step 1: find a pointer in .rdata that:
-	//	-points to somewhere else in .rdata and
-	//      -is immediately followed by a pointer inside .text
-	//	-keep track of the count of class members
-	for (uint32_t i = 0; i < count; ++i) {
-		if (is_rdata_ptr(haystack[i])) {
-			if (is_text_ptr(haystack[i + 1])) {
-				uint32_t ol_offset = (uint32_t)(12 + (haystack[i] - base));
-				uint32_t func_count = 0;
+	if (!reloc_offset || ((uint64_t)reloc_offset + reloc_size > p.buffer_size)) {
+		Log("No relocation directory, vtables are found by scanning .rdata");
+		return;
+	}
+
+	//each block is a 4k page followed by 16 bit entries of type << 12 | page offset
+	const auto start = (const char*)p.buffer + reloc_offset;
+	slots.reserve(reloc_size / sizeof(uint16_t));
+
+	bool sorted = true;
+	uint32_t pos = 0;
+	while (pos + sizeof(IMAGE_BASE_RELOCATION) <= reloc_size) {
+		IMAGE_BASE_RELOCATION block;
+		memcpy(&block, start + pos, sizeof(block));
+		if ((block.SizeOfBlock < sizeof(block)) || (block.SizeOfBlock > reloc_size - pos)) break;
+
+		const auto entries = (const uint16_t*)(start + pos + sizeof(block));
+		const auto count = (block.SizeOfBlock - sizeof(block)) / sizeof(uint16_t);
+		for (size_t i = 0; i < count; ++i) {
+			//IMAGE_REL_BASED_ABSOLUTE entries only pad the block
+			if ((entries[i] >> 12) != IMAGE_REL_BASED_DIR64) continue;
+			const uint32_t slot = block.VirtualAddress + (entries[i] & 0xFFF);
+			if ((uint64_t)slot + sizeof(uint64_t) > p.buffer_size) continue;
+			if (!slots.empty() && (slot <= slots.back())) sorted = false;
+			slots.push_back(slot);
+		}
+		pos += block.SizeOfBlock;
+	}
+
+	if (!sorted) {
+		std::sort(slots.begin(), slots.end());
+		slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+	}
+	slots.shrink_to_fit();
+
+	Log("   .reloc: %u pointer slots", (unsigned)slots.size());
+}
+
+static size_t pointer_slot_range(const std::vector<uint32_t>& slots, uint32_t begin, uint32_t end, const uint32_t** first) {
+	const auto lo = std::lower_bound(slots.begin(), slots.end(), begin);
+	const auto hi = std::lower_bound(lo, slots.end(), end);
+	*first = slots.data() + (lo - slots.begin());
+	return (size_t)(hi - lo);
+}
+
+extern size_t find_pointer_slots(uint32_t begin, uint32_t end, const uint32_t** first) {
+	return pointer_slot_range(GameProcessInfo.exe.pointer_slots, begin, end, first);
+}
+
+extern bool is_pointer_slot(uint32_t offset) {
+	const auto& slots = GameProcessInfo.exe.pointer_slots;
+	return std::binary_search(slots.begin(), slots.end(), offset);
+}
+
+struct VtableCandidate {
+	uint32_t vtable_offset;
+	uint32_t object_locator_offset;
+	uint32_t func_count;
+};
+
+//heuristic used when the image has no relocations, find a pointer in .rdata that:
+//	-points to somewhere else in .rdata and
+//	-is immediately followed by a pointer inside .text
+//	-keep track of the count of class members
+static void find_vtables_by_scan(const ProcessInfo& p, size_t begin, size_t end, std::vector<VtableCandidate>& Candidates) {
+	const auto text_start = p.base_address + p.exe.text.offset;
+	const auto text_end = text_start + p.exe.text.size;
+#define is_text_ptr(PTR) (((PTR) >= text_start) && ((PTR) <= text_end))
+
+	const auto rdata_start = p.base_address + p.exe.rdata.offset;
+	const auto rdata_end = rdata_start + p.exe.rdata.size;
+
+	const uint64_t* haystack = (uint64_t*)((char*)p.buffer + p.exe.rdata.offset);
+	const uint32_t count = p.exe.rdata.size / sizeof(*haystack);
+	const uint32_t rdata_offset = p.exe.rdata.offset;
+	const uint64_t base = p.base_address;
+
+	const auto& kernels = scan_kernels();
+	const auto last = (uint32_t)std::min<size_t>(end, count);
+	for (uint32_t i = (uint32_t)begin; i < last; ++i) {
+		//skip to the next pointer into .rdata, a vtable is preceded by one to its CompleteObjectLocator
+		i += (uint32_t)kernels.find_qword_in_range(haystack + i, last - i, rdata_start, rdata_end);
+		if (i >= last) break;
+
+		if (is_text_ptr(haystack[i + 1])) {
+			uint32_t ol_offset = (uint32_t)(12 + (haystack[i] - base));
+			uint32_t func_count = 0;
+			++i;
+			uint32_t vt_offset = (rdata_offset + (i * sizeof(*haystack)));
+			while (is_text_ptr(haystack[i])) {
+				++func_count;
 				++i;
-				uint32_t vt_offset = (rdata_offset + (i * sizeof(*haystack)));
-				while (is_text_ptr(haystack[i])) {
-					++func_count;
-					++i;
-				}
-				--i;
-				
-				Candidates.push_back(Candidate{ vt_offset, ol_offset, func_count });
 			}
+			--i;
+			
+			Candidates.push_back(VtableCandidate{ vt_offset, ol_offset, func_count });
+		}
+	}
+
+#undef is_text_ptr
+}
+
+//walk only the relocated pointers of .rdata: a vtable is a run of adjacent slots into .text
+//preceded by a slot pointing at a CompleteObjectLocator, which is checked by its signature and self offset
+static void find_vtables_by_relocs(const ProcessInfo& p, size_t begin, size_t end, std::vector<VtableCandidate>& Candidates) {
+	const auto text_start = p.base_address + p.exe.text.offset;
+	const auto text_end = text_start + p.exe.text.size;
+#define is_text_ptr(PTR) (((PTR) >= text_start) && ((PTR) <= text_end))
+
+	const auto rdata_start = p.base_address + p.exe.rdata.offset;
+	const auto rdata_end = rdata_start + p.exe.rdata.size;
+#define is_rdata_ptr(PTR) (((PTR) >= rdata_start) && ((PTR) <= rdata_end))
+
+	const char* const baseptr = (char*)p.buffer;
+	const uint64_t base = p.base_address;
+
+	const uint32_t* slots;
+	const auto count = pointer_slot_range(p.exe.pointer_slots, p.exe.rdata.offset, p.exe.rdata.offset + p.exe.rdata.size, &slots);
+#define slot_value(I) (*(const uint64_t*)(baseptr + slots[I]))
+
+	for (size_t i = begin; (i < end) && (i + 1 < count); ++i) {
+		if (slots[i + 1] != slots[i] + 8) continue;
+		const auto col = slot_value(i);
+		if (!is_rdata_ptr(col) || !is_text_ptr(slot_value(i + 1))) continue;
+
+		//x64 object locators have signature 1 and store their own image offset
+		const auto col_offset = (uint32_t)(col - base);
+		if ((uint64_t)col_offset + 24 > p.buffer_size) continue;
+		uint32_t locator[6];
+		memcpy(locator, baseptr + col_offset, sizeof(locator));
+		if ((locator[0] != 1) || (locator[5] != col_offset)) continue;
+
+		const uint32_t vt_offset = slots[i + 1];
+		uint32_t func_count = 0;
+		++i;
+		while ((i < count) && (slots[i] == vt_offset + func_count * 8) && is_text_ptr(slot_value(i))) {
+			++func_count;
+			++i;
 		}
+		--i;
+
+		Candidates.push_back(VtableCandidate{ vt_offset, col_offset + 12, func_count });
 	}
 
-	GameProcessInfo.rtti_map.clear();
-	GameProcessInfo.rtti_map.reserve(32768);
+#undef slot_value
+#undef is_text_ptr
+#undef is_rdata_ptr
+}
+
+extern void turbo_vtable_algorithm() {
+	turbo_vtable_algorithm(GameProcessInfo);
+}
+
+extern void turbo_vtable_algorithm(ProcessInfo& p) {
+	// Utilize the 2 step turbo vtable algorithm to automagically resolve
+	// an rtti mangled name into the corresponding vtable pointer
+	// no, there are no google results for "turbo vtable algorithm" yet
+
+	const auto data_start = p.exe.data.offset;
+	const auto data_end = data_start + p.exe.data.size;
+#define is_data_offset(OFF) (((OFF) >= data_start) && ((OFF) <= data_end))
+
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	std::vector<VtableCandidate> Candidates;
+	Candidates.reserve(32768);
+
+	//step 1: collect vtable candidates, from the relocation table when the image has one
+	//a vtable that crosses a chunk boundary is finished by the chunk it starts in, the next chunk
+	//skips the rest of it because pointers into .text never start a candidate
+	const bool use_relocs = !p.exe.pointer_slots.empty();
+	const uint32_t* slots;
+	const size_t items = use_relocs ?
+		pointer_slot_range(p.exe.pointer_slots, p.exe.rdata.offset, p.exe.rdata.offset + p.exe.rdata.size, &slots) :
+		(p.exe.rdata.size / sizeof(uint64_t));
+	const auto grain = parallel_grain(items, 16384);
+	std::vector<std::vector<VtableCandidate>> parts((items + grain - 1) / grain);
+	parallel_for(items, grain, [&](size_t begin, size_t end) {
+		auto& part = parts[begin / grain];
+		if (use_relocs) find_vtables_by_relocs(p, begin, end, part);
+		else find_vtables_by_scan(p, begin, end, part);
+	});
+	for (const auto& part : parts) Candidates.insert(Candidates.end(), part.begin(), part.end());
+
+	p.rtti_map.clear();
+	p.rtti_map.reserve(32768);
 
 	//step 2: heuristically determine which candidates are accurate by:
 	//              -checking if the typedescriptor pointer is in .data and
 	//              -the type descriptor name starts with '.'
 	//		-on collisions, choose the class with more members
 	const auto count2 = Candidates.size();
-	const char* const baseptr = (char*)GameProcessInfo.buffer;
+	const char* const baseptr = (char*)p.buffer;
 	for (size_t i = 0; i < count2; ++i) {
 		uint32_t td_offset = *(uint32_t*)(baseptr + Candidates[i].object_locator_offset);
 		if (!is_data_offset(td_offset)) continue;
@@ -158,14 +389,17 @@ extern void turbo_vtable_algorithm() {
 		if (name[0] != '.') continue;
 		const RTTI_Info info{name, Candidates[i].func_count, Candidates[i].vtable_offset};
 
-		auto& result = GameProcessInfo.rtti_map[std::string{ name }];
+		auto& result = p.rtti_map[std::string{ name }];
 		if (result.func_count < info.func_count) {
 			result = info;
 		}
 	}
 
-#undef is_text_ptr
-#undef is_rdata_ptr
+	QueryPerformanceCounter(&end);
+	const auto ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+	Log("Vtables: %u classes from %u candidates (%s), %.2fms", (unsigned)p.rtti_map.size(), (unsigned)count2,
+		use_relocs ? "relocation slots" : ".rdata scan", ms);
+
 #undef is_data_offset
 }
 
@@ -200,40 +434,81 @@ extern void scan_vtable() {
 		{0, GameSettingFlag::OriginUnknown},
 	};
 
-	const auto start_offset = GameProcessInfo.exe.rdata.offset;
-	for (uint64_t vt = 0; settings_vtable[vt].rtti_name; ++vt) {
-		uintptr_t offset = start_offset;
-                char tmp_name[128];
-		uintptr_t instance_ptr = find_vtable(settings_vtable[vt].rtti_name);
+	//find_any_qword takes at most SCAN_MAX_NEEDLES needles, the list ends with a null entry
+	static_assert((sizeof(settings_vtable) / sizeof(settings_vtable[0])) - 1 <= SCAN_MAX_NEEDLES, "too many setting vtables for one find_any_qword pass");
+	uint64_t needles[SCAN_MAX_NEEDLES];
+	unsigned needle_vt[SCAN_MAX_NEEDLES];
+	unsigned needle_count = 0;
+	for (unsigned vt = 0; settings_vtable[vt].rtti_name && (needle_count < SCAN_MAX_NEEDLES); ++vt) {
+		const uintptr_t instance_ptr = find_vtable(settings_vtable[vt].rtti_name);
 		if (!instance_ptr) continue;
-		while (find(buffer, buffer + sz, &offset, instance_ptr)) {
-			Setting s;
-			s.m_address = GameProcessInfo.base_address + offset;
-			s.m_setting = *(buffer + offset).as<const GameSetting*>();
-                        
-			const auto name_addr = (uintptr_t)s.m_setting.Name;
-
-			if ((name_addr - GameProcessInfo.base_address) < GameProcessInfo.buffer_size) {
-				//the name is in static memory, use that
-				s.m_name = (name_addr - GameProcessInfo.base_address) + (char*)GameProcessInfo.buffer;
-			}
-			else {
-				if (!RPM(s.m_setting.Name, tmp_name, 128)) {
-					continue;
-				}
-				tmp_name[127] = 0;
-				s.m_name = tmp_name;
-			}
-			
-			s.m_flags = settings_vtable[vt].origin | s.GetGameSettingType(s.m_name[0]);
-			for (const auto chr : s.m_name) {
-				s.m_search_name += (char)::tolower(chr);
+		needle_vt[needle_count] = vt;
+		needles[needle_count++] = instance_ptr;
+	}
+
+	//one pass for all setting vtables, the hits are then grouped by vtable in the order of settings_vtable
+	struct Hit {
+		unsigned vt;
+		uint64_t offset;
+	};
+	const auto start_offset = GameProcessInfo.exe.rdata.offset;
+	const auto haystack = (buffer + start_offset).as<const uint64_t*>();
+	const auto count = needle_count ? (size_t)((sz - start_offset) / sizeof(uint64_t)) : 0;
+	const auto& kernels = scan_kernels();
+
+	const auto grain = parallel_grain(count, 1 << 20);
+	std::vector<std::vector<Hit>> parts((count + grain - 1) / grain);
+	parallel_for(count, grain, [&](size_t begin, size_t end) {
+		auto& part = parts[begin / grain];
+		for (size_t i = begin; i < end; ++i) {
+			i += kernels.find_any_qword(haystack + i, end - i, needles, needle_count);
+			if (i >= end) break;
+			unsigned n = 0;
+			while (needles[n] != haystack[i]) ++n;
+			part.push_back(Hit{ needle_vt[n], start_offset + i * sizeof(uint64_t) });
+		}
+	}, TaskPriority_High);
+
+	std::vector<Hit> hits;
+	for (const auto& part : parts) hits.insert(hits.end(), part.begin(), part.end());
+	std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.vt < b.vt; });
+
+	//a hit inside the previous setting of the same vtable is part of that setting
+	uint64_t next_offset = 0;
+	for (size_t h = 0; h < hits.size(); ++h) {
+		const auto vt = hits[h].vt;
+		const auto offset = hits[h].offset;
+		if (h && (hits[h - 1].vt != vt)) next_offset = 0;
+		if (offset < next_offset) continue;
+		next_offset = offset + sizeof(uint64_t);
+
+		char tmp_name[128];
+		Setting s;
+		s.m_address = GameProcessInfo.base_address + offset;
+		s.m_setting = *(buffer + offset).as<const GameSetting*>();
+
+		const auto name_addr = (uintptr_t)s.m_setting.Name;
+
+		if ((name_addr - GameProcessInfo.base_address) < GameProcessInfo.buffer_size) {
+			//the name is in static memory, use that
+			s.m_name = (name_addr - GameProcessInfo.base_address) + (char*)GameProcessInfo.buffer;
+		}
+		else {
+			if (!RPM(s.m_setting.Name, tmp_name, 128)) {
+				continue;
 			}
-			s.m_current = s.m_setting.Active;
-			s.m_active = s.m_setting.Active;
-			results.push_back(s);
-			offset += sizeof(GameSetting);
+			tmp_name[127] = 0;
+			s.m_name = tmp_name;
 		}
+		
+		s.m_flags = settings_vtable[vt].origin | s.GetGameSettingType(s.m_name[0]);
+		for (const auto chr : s.m_name) {
+			s.m_search_name += (char)::tolower(chr);
+		}
+		s.m_current = s.m_setting.Active;
+		s.m_active = s.m_setting.Active;
+		results.push_back(s);
+		next_offset = offset + sizeof(GameSetting);
 	}
 }
 
@@ -277,6 +552,25 @@ static std::string stringify_value(const GameValue& v, const uint64_t t) {
 	return "<error>";
 }
 
+//the text export is rendered from the binary export so both always agree
+static void write_results(std::vector<Setting>::const_iterator begin, std::vector<Setting>::const_iterator end, const char* bin_path, FILE* text) {
+	const auto data = export_build(begin, end);
+	if (bin_path) export_save(bin_path, data);
+
+	ExportView view;
+	if (text && export_view(data.data(), data.size(), &view)) {
+		export_write_text(view, text);
+	}
+}
+
+extern void write_settings_text(FILE* f, const char* bin_path) {
+	write_results(results.cbegin(), results.cend(), bin_path, f);
+}
+
+extern std::vector<Setting>& scanned_settings(void) {
+	return results;
+}
+
 static void EditSetting(Setting& s) {
 	ImGui::Text("Setting Starfield.exe+%X", (Pointer(s.m_address) - GameProcessInfo.base_address).as<unsigned>());
 	ImGui::Text("Type Name: %s", s.GetGameSettingTypeName(s.m_flags));
@@ -322,9 +616,21 @@ static void EditSetting(Setting& s) {
 	}
 	ImGui::Text("Active Value %s", str_active.c_str());
 
+	bool frozen = is_setting_frozen(s.m_address);
 	if (ImGui::Button("Apply")) {
 		s.Update();
 		s.m_flags |= GameSettingFlag::FlagChanged;
+		if (frozen) freeze_setting(s, s.m_current);
+	}
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Freeze", &frozen)) {
+		if (frozen) {
+			freeze_setting(s, s.m_current);
+			s.m_flags |= GameSettingFlag::FlagChanged;
+		}
+		else {
+			unfreeze_setting(s.m_address);
+		}
 	}
 	ImGui::SameLine();
 
@@ -460,35 +766,76 @@ extern void scan_window_draw(void) {
 		ImGui::Separator();
 		ImGui::Separator();
 
-		if (ImGui::Button("Save Search Results to ./search_results.txt")) {
+		if (ImGui::Button("Save Search Results to ./search_results.txt and ./search_results.bin")) {
 			FILE* f = NULL;
 			fopen_s(&f, "search_results.txt", "wb");
 			assert(f != NULL);
-			fprintf(f, "## Generated by LiveINI - https://www.nexusmods.com/starfield/mods/976\r\n");
-			const auto& v = GameProcessInfo.exe.version;
-			fprintf(f, "## Starfield EXE version: %u.%u.%u.%u\r\n", v.major, v.minor, v.build, v.revision);
-			fprintf(f, "## Double pipe characters are used as the unique delimiter\r\n");
-			fprintf(f, "## Setting || DefaultValue || INIValue || CurrentValue || Origin\r\n");
-
-			for (auto i = results_begin; i != results_end; ++i) {
-				auto vdefault = stringify_value(i->m_setting.Default, i->m_flags);
-				auto vini = stringify_value(i->m_setting.Active, i->m_flags);
-				auto vcur = stringify_value(i->m_current, i->m_flags);
-				auto origin = Setting::GetGameSettingOriginName(i->m_flags);
-				fprintf(f, "%s || %s || %s || %s || %s\r\n", i->m_name.c_str(), vdefault.c_str(), vini.c_str(), vcur.c_str(), origin);
-			}
-
+			write_results(results_begin, results_end, "search_results.bin", f);
 			fclose(f);
 		}
 
 		if (ImGui::Button("Reset All changed settings")) {
+			unfreeze_all();
 			reset_changed_settings();
 		}
+
+		ImGui::Separator();
+		ImGui::Separator();
+
+		{
+			static char profile_path[MAX_PATH] = "profile.ini";
+			static ProfileTransaction txn;
+			static ProfileResult last{};
+			static bool applied = false;
+
+			ImGui::InputText("Profile", profile_path, sizeof(profile_path));
+			if (ImGui::Button("Apply Profile")) {
+				std::vector<ProfileEntry> entries;
+				if (profile_load(profile_path, entries)) {
+					last = profile_apply(entries, results, &txn);
+					applied = true;
+				}
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Roll back Profile") && !txn.undo.empty()) {
+				profile_rollback(txn, results);
+			}
+			if (applied) {
+				ImGui::Text("%u entries: %u written, %u unchanged, %u unknown, %u unsupported, %u invalid, %u failed",
+					last.entries, last.written, last.unchanged, last.unknown, last.unsupported, last.invalid, last.failed);
+				ImGui::Text("%.2fms, %u reads, %u writes, %u can be rolled back", last.elapsed_ms, last.batch.reads, last.batch.writes, (unsigned)txn.undo.size());
+			}
+		}
+
+		ImGui::Separator();
+		ImGui::Separator();
+
+		if (ImGui::Button("Freeze search results at their current value")) {
+			for (auto i = results_begin; i != results_end; ++i) {
+				freeze_setting(*i, i->m_current);
+			}
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Unfreeze all")) {
+			unfreeze_all();
+		}
+
+		int rate = (int)freeze_get_rate();
+		if (ImGui::SliderInt("Freeze rate (Hz)", &rate, 1, 1000, "%d", ImGuiSliderFlags_Logarithmic)) {
+			freeze_set_rate((unsigned)rate);
+		}
+
+		const auto fs = freeze_stats();
+		ImGui::Text("Frozen: %u, cycles: %llu, restored: %llu, dropped: %llu", fs.frozen, fs.cycles, fs.rewritten, fs.dropped);
+		ImGui::Text("Cycle: %.1fus (avg %.1fus), %.1f reads and %.2f writes per cycle, %.2f%% cpu",
+			fs.last_cycle_us, fs.avg_cycle_us, fs.reads_per_cycle, fs.writes_per_cycle, fs.cpu_percent);
 		ImGui::TreePop();
 	}
 
 	ImGui::SameLine();
 	ImGui::Text("| Results: %u/%I64d", results_count, results.size());
+	ImGui::SameLine();
+	ImGui::Text("| Frozen: %u", freeze_stats().frozen);
 
 	ImGui::BeginChild("results_section", ImVec2{}, false, ImGuiWindowFlags_NoScrollbar);
 
@@ -509,18 +856,31 @@ extern void scan_window_draw(void) {
 
 
 extern void perform_exe_version_analysis() {
+	const auto found = perform_exe_version_analysis(GameProcessInfo);
+	assert(found);
+	(void)found;
+}
+
+extern bool perform_exe_version_analysis(ProcessInfo& p) {
 	// instead of using the windows api for getting the executable version information its actually faster
 	// to brute-force search the .rsrc section of the exe since we already have it in a buffer
 
 	// L"ProductVersion"
 	AOB_SIG aob = aob_compile("50 00 72 00 6f 00 64 00 75 00 63 00 74 00 56 00 65 00 72 00 73 00 69 00 6f 00 6e 00");
-	auto offset = aob_scan(GameProcessInfo.buffer, (unsigned)GameProcessInfo.buffer_size, GameProcessInfo.exe.rsrc.offset, aob);
+	auto offset = aob_scan(p.buffer, (unsigned)p.buffer_size, p.exe.rsrc.offset, aob);
 	aob_free(aob);
-	assert(offset != AOB_NO_MATCH);
+	if (offset == AOB_NO_MATCH) {
+		Log("No ProductVersion resource");
+		return false;
+	}
 	offset += 30; // L"ProductVersion" + wchar_t null terminator 
-	const char* buffer = (char*)GameProcessInfo.buffer;
-	auto& v = GameProcessInfo.exe.version;
+	const char* buffer = (char*)p.buffer;
+	auto& v = p.exe.version;
 	auto ret = swscanf_s((wchar_t*) &buffer[offset], L"%u.%u.%u.%u", &v.major, &v.minor, &v.build, &v.revision);
-	assert(ret == 4);
+	if (ret != 4) {
+		Log("Could not parse ProductVersion");
+		return false;
+	}
 	Log("Game Version: %u.%u.%u.%u", v.major, v.minor, v.build, v.revision);
+	return true;
 }
\ No newline at end of file
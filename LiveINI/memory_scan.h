@@ -1,11 +1,38 @@
 #pragma once
 
+#include "setting.h"
+
 extern uintptr_t find_vtable(const char* const rtti_name);
 extern void scan_window_draw(void);
 extern void scan_vtable(void);
 
+//settings found by the last scan_vtable
+extern std::vector<Setting>& scanned_settings(void);
+//write every scanned setting in the search_results.txt format (if f is not null), sorted by name
+//the binary export it is rendered from is also saved to bin_path if it is not null
+extern void write_settings_text(FILE* f, const char* bin_path);
+
+struct FunctionInfo {
+	uint32_t begin; //range containing the offset
+	uint32_t end;
+	uint32_t entry; //start of the function the range belongs to
+};
+
+//find the .pdata range containing an image offset in O(log n), false for leaf functions and non code
+extern bool find_function(uint32_t offset, FunctionInfo* out);
+
+//image offsets of the relocated pointers in [begin, end) from the .reloc index, returns the count
+extern size_t find_pointer_slots(uint32_t begin, uint32_t end, const uint32_t** first);
+//true if the image holds an absolute (relocated) pointer at offset
+extern bool is_pointer_slot(uint32_t offset);
+
 //perform the following steps in this exact order:
 extern void perform_exe_section_analysis();
 extern void perform_exe_version_analysis();
 //extern void build_rtti_list(void);
-extern void turbo_vtable_algorithm();
\ No newline at end of file
+extern void turbo_vtable_algorithm();
+
+//the same steps on an image other than GameProcessInfo (see batch.cpp), safe to run for different images at once
+extern void perform_exe_section_analysis(ProcessInfo& p);
+extern bool perform_exe_version_analysis(ProcessInfo& p); //false if the image has no ProductVersion resource
+extern void turbo_vtable_algorithm(ProcessInfo& p);
\ No newline at end of file
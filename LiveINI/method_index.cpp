@@ -0,0 +1,79 @@
+#include "method_index.h"
+
+static struct {
+	std::vector<RTTI_Info> classes; //sorted by name so equal ranges list classes in a stable order
+	std::vector<MethodRef> refs;
+	size_t methods;
+} Index{};
+
+extern void method_index_reset(void) {
+	Index.classes = std::vector<RTTI_Info>{};
+	Index.refs = std::vector<MethodRef>{};
+	Index.methods = 0;
+}
+
+extern void method_index_build(void) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	method_index_reset();
+
+	const auto text_start = GameProcessInfo.exe.text.offset;
+	const auto text_end = text_start + GameProcessInfo.exe.text.size;
+	const auto base = GameProcessInfo.base_address;
+
+	Index.classes.reserve(GameProcessInfo.rtti_map.size());
+	size_t slots = 0;
+	for (const auto& x : GameProcessInfo.rtti_map) {
+		if ((uint64_t)x.second.vtable_offset + (uint64_t)x.second.func_count * sizeof(uintptr_t) > GameProcessInfo.buffer_size) continue;
+		Index.classes.push_back(x.second);
+		slots += x.second.func_count;
+	}
+	std::sort(Index.classes.begin(), Index.classes.end(), [](const RTTI_Info& a, const RTTI_Info& b) { return strcmp(a.name, b.name) < 0; });
+
+	Index.refs.reserve(slots);
+	for (uint32_t id = 0; id < Index.classes.size(); ++id) {
+		const auto& c = Index.classes[id];
+		const uintptr_t* methods = (uintptr_t*)((char*)GameProcessInfo.buffer + c.vtable_offset);
+		for (uint32_t i = 0; i < c.func_count; ++i) {
+			const auto rva = methods[i] - base;
+			if ((methods[i] < base) || (rva < text_start) || (rva >= text_end)) continue;
+			Index.refs.push_back(MethodRef{ (uint32_t)rva, id, i });
+		}
+	}
+
+	//classes were visited in name order, a stable sort on rva keeps them that way
+	std::stable_sort(Index.refs.begin(), Index.refs.end(), [](const MethodRef& a, const MethodRef& b) { return a.rva < b.rva; });
+
+	for (size_t i = 0; i < Index.refs.size(); ++i) {
+		Index.methods += (!i || (Index.refs[i].rva != Index.refs[i - 1].rva));
+	}
+
+	QueryPerformanceCounter(&end);
+	const auto ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+	Log("Method index: %u methods in %u vtable slots, %.0fms", (unsigned)Index.methods, (unsigned)Index.refs.size(), ms);
+}
+
+extern bool method_index_ready(void) {
+	return !Index.refs.empty();
+}
+
+extern size_t method_index_find(uint32_t rva, const MethodRef** first) {
+	const auto cmp_lo = [](const MethodRef& a, uint32_t v) { return a.rva < v; };
+	const auto cmp_hi = [](uint32_t v, const MethodRef& a) { return v < a.rva; };
+
+	const auto lo = std::lower_bound(Index.refs.begin(), Index.refs.end(), rva, cmp_lo);
+	const auto hi = std::upper_bound(lo, Index.refs.end(), rva, cmp_hi);
+	*first = Index.refs.data() + (lo - Index.refs.begin());
+	return hi - lo;
+}
+
+extern const RTTI_Info& method_index_class(uint32_t class_id) {
+	return Index.classes[class_id];
+}
+
+extern void method_index_counts(size_t* methods, size_t* slots) {
+	*methods = Index.methods;
+	*slots = Index.refs.size();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "main.h"
+
+//inverted index from method rva to every vtable slot that holds it, built once per scan
+//sorted by (rva, class, slot) so all classes sharing a method (e.g. an inherited base implementation) are adjacent
+
+struct MethodRef {
+	uint32_t rva;      //image offset of the method
+	uint32_t class_id; //index for method_index_class
+	uint32_t slot;     //index into the vtable
+};
+
+//build from the current rtti_map, call after turbo_vtable_algorithm
+extern void method_index_build(void);
+extern void method_index_reset(void);
+
+extern bool method_index_ready(void);
+
+/// every slot holding the method at rva in O(log n), first is set to the start of the range
+/// returns the number of refs, the range stays valid until the next build or reset
+extern size_t method_index_find(uint32_t rva, const MethodRef** first);
+
+extern const RTTI_Info& method_index_class(uint32_t class_id);
+
+//number of distinct methods and total slots
+extern void method_index_counts(size_t* methods, size_t* slots);
\ No newline at end of file
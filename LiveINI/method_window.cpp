@@ -1,5 +1,9 @@
 #include "main.h"
 #include "method_window.h"
+#include "insn_map.h"
+#include "memory_scan.h"
+#include "method_index.h"
+#include "image_sections.h"
 
 
 struct Result {
@@ -12,37 +16,51 @@ struct Result {
 extern void draw_method_window() {
         static char buffer[64];
         static std::vector<Result> Results{};
+        static bool mid_instruction = false;
+        static bool in_function = false;
+        static FunctionInfo function{};
 
         if (!GameProcessInfo.rtti_map.size()) {
                 ImGui::Text("Press Scan Starfield in the log window");
                 return;
         }
+        image_text_require();
 
         if (ImGui::InputText("Offset", buffer, 64)) {
                 const auto text_start = GameProcessInfo.base_address + GameProcessInfo.exe.text.offset;
                 const auto text_end = text_start + GameProcessInfo.exe.text.size;
                 #define is_text_ptr(PTR) (((PTR) >= text_start) && ((PTR) <= text_end))
 
-                const auto func_offset = strtoull(buffer, NULL, 16);
-                uint64_t ptr = GameProcessInfo.base_address + func_offset;
+                auto func_offset = strtoull(buffer, NULL, 16);
                 Results.clear();
+                mid_instruction = insn_map_ready() && is_text_ptr(GameProcessInfo.base_address + func_offset) && !is_instruction_start((uint32_t)func_offset);
+
+                //an offset inside a function is looked up by the function it belongs to
+                in_function = (func_offset <= UINT32_MAX) && find_function((uint32_t)func_offset, &function);
+                if (in_function) func_offset = function.entry;
+                uint64_t ptr = GameProcessInfo.base_address + func_offset;
 
                 if (is_text_ptr(ptr)) {
-                        for (const auto& x : GameProcessInfo.rtti_map) {
-                                const uintptr_t* methods = (uintptr_t*)((char*)GameProcessInfo.buffer + x.second.vtable_offset);
-
-                                for (uint32_t i = 0; i < x.second.func_count; ++i) {
-                                        if (ptr == methods[i]) {
-                                                Log("Found Method");
-                                                Results.push_back(Result{ x.second.name, i, x.second.func_count, x.second.vtable_offset + (i * 8) });
-                                        }
-                                }
+                        //every class whose vtable holds the method, including those inheriting it unchanged
+                        const MethodRef* refs;
+                        const auto count = method_index_find((uint32_t)func_offset, &refs);
+                        for (size_t i = 0; i < count; ++i) {
+                                const auto& c = method_index_class(refs[i].class_id);
+                                Results.push_back(Result{ c.name, refs[i].slot, c.func_count, c.vtable_offset + (refs[i].slot * 8) });
                         }
                 }
 
                 #undef is_text_ptr
         }
 
+        ImGui::Text("%u vtable slots", (unsigned)Results.size());
+        if (in_function) {
+                ImGui::Text("Function Starfield.exe+0x%X (range 0x%X - 0x%X)", function.entry, function.begin, function.end);
+        }
+        if (mid_instruction) {
+                ImGui::Text("Offset is inside an instruction, not the start of one");
+        }
+
         ImGuiListClipper clip;
         clip.Begin((int)Results.size(), ImGui::GetTextLineHeightWithSpacing());
 
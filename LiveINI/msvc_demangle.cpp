@@ -0,0 +1,290 @@
+#include "msvc_demangle.h"
+
+#include <algorithm>
+#include <cstring>
+
+//names and template argument types are memoized so later occurrences can refer back with a single digit
+//every template argument list starts with empty tables of its own
+static constexpr size_t BACKREF_MAX = 10;
+
+struct Demangler {
+	const char* p;
+	std::vector<std::string> names;
+	std::vector<std::string> types;
+	std::vector<std::string>* tokens;
+	bool ok;
+
+	bool fail() {
+		ok = false;
+		return false;
+	}
+
+	void add_token(const std::string& t) {
+		if (std::find(tokens->begin(), tokens->end(), t) == tokens->end()) tokens->push_back(t);
+	}
+
+	//identifier up to and including '@'
+	bool simple_name(std::string* out) {
+		const auto end = strchr(p, '@');
+		if (!end || (end == p)) return fail();
+		out->assign(p, end);
+		p = end + 1;
+		return true;
+	}
+
+	//one component of a qualified name
+	bool fragment(std::string* out) {
+		if ((*p >= '0') && (*p <= '9')) {
+			const size_t i = *p++ - '0';
+			if (i >= names.size()) return fail();
+			*out = names[i];
+			return true;
+		}
+
+		if ((p[0] == '?') && (p[1] == '$')) {
+			p += 2;
+			std::string name;
+			if (!simple_name(&name)) return false;
+			add_token(name);
+
+			auto outer_names = std::move(names);
+			auto outer_types = std::move(types);
+			names.clear();
+			types.clear();
+			names.push_back(name);
+
+			std::string args;
+			const bool parsed = template_args(&args);
+
+			names = std::move(outer_names);
+			types = std::move(outer_types);
+			if (!parsed) return false;
+
+			*out = name + '<' + args + '>';
+			if (names.size() < BACKREF_MAX) names.push_back(*out);
+			return true;
+		}
+
+		if (!strncmp(p, "?A0x", 4)) {
+			std::string hash;
+			++p;
+			if (!simple_name(&hash)) return false;
+			*out = "`anonymous namespace'";
+			if (names.size() < BACKREF_MAX) names.push_back(*out);
+			return true;
+		}
+
+		//local scopes, operators and other special names
+		if (*p == '?') return fail();
+
+		if (!simple_name(out)) return false;
+		add_token(*out);
+		if (names.size() < BACKREF_MAX) names.push_back(*out);
+		return true;
+	}
+
+	//fragments are stored innermost first and end with an empty fragment
+	bool qualified_name(std::string* out) {
+		std::vector<std::string> parts;
+		while (*p != '@') {
+			if (!*p) return fail();
+			std::string part;
+			if (!fragment(&part)) return false;
+			parts.push_back(std::move(part));
+		}
+		++p;
+		if (parts.empty()) return fail();
+
+		out->clear();
+		for (auto i = parts.size(); i-- > 0; ) {
+			out->append(parts[i]);
+			if (i) out->append("::");
+		}
+		return true;
+	}
+
+	//0-9 encode 1-10, otherwise hex digits A-P terminated by '@', '?' negates
+	bool number(std::string* out) {
+		bool negative = false;
+		if (*p == '?') {
+			negative = true;
+			++p;
+		}
+
+		uint64_t value = 0;
+		if ((*p >= '0') && (*p <= '9')) {
+			value = (uint64_t)(*p++ - '0') + 1;
+		}
+		else {
+			while (*p != '@') {
+				if ((*p < 'A') || (*p > 'P')) return fail();
+				value = (value << 4) | (uint64_t)(*p++ - 'A');
+			}
+			++p;
+		}
+
+		*out = negative ? ('-' + std::to_string(value)) : std::to_string(value);
+		return true;
+	}
+
+	const char* primitive(char c) {
+		switch (c) {
+		case 'C': return "signed char";
+		case 'D': return "char";
+		case 'E': return "unsigned char";
+		case 'F': return "short";
+		case 'G': return "unsigned short";
+		case 'H': return "int";
+		case 'I': return "unsigned int";
+		case 'J': return "long";
+		case 'K': return "unsigned long";
+		case 'M': return "float";
+		case 'N': return "double";
+		case 'O': return "long double";
+		case 'X': return "void";
+		default: return nullptr;
+		}
+	}
+
+	const char* extended_primitive(char c) {
+		switch (c) {
+		case 'J': return "__int64";
+		case 'K': return "unsigned __int64";
+		case 'N': return "bool";
+		case 'Q': return "char8_t";
+		case 'S': return "char16_t";
+		case 'U': return "char32_t";
+		case 'W': return "wchar_t";
+		default: return nullptr;
+		}
+	}
+
+	//pointee of a pointer or reference: optional E (__ptr64), then cv qualifiers A-D
+	bool indirect(const char* suffix, bool const_pointer, std::string* out) {
+		if (*p == 'E') ++p;
+		const char cv = *p++;
+		if ((cv < 'A') || (cv > 'D')) return fail();
+
+		std::string pointee;
+		if (!type(&pointee)) return false;
+
+		out->clear();
+		if ((cv == 'B') || (cv == 'D')) out->append("const ");
+		if ((cv == 'C') || (cv == 'D')) out->append("volatile ");
+		out->append(pointee);
+		out->append(suffix);
+		if (const_pointer) out->append(" const");
+		return true;
+	}
+
+	bool type(std::string* out) {
+		const char c = *p++;
+
+		if (const auto prim = primitive(c)) {
+			*out = prim;
+			return true;
+		}
+
+		switch (c) {
+		case 'V':
+		case 'U':
+		case 'T':
+			return qualified_name(out);
+		case 'W':
+			if ((*p < '0') || (*p > '7')) return fail();
+			++p;
+			return qualified_name(out);
+		case '_':
+			if (const auto prim = extended_primitive(*p++)) {
+				*out = prim;
+				return true;
+			}
+			return fail();
+		case 'P': return indirect("*", false, out);
+		case 'Q': return indirect("*", true, out);
+		case 'A': return indirect("&", false, out);
+		case '$':
+			if (!strncmp(p, "$Q", 2)) {
+				p += 2;
+				return indirect("&&", false, out);
+			}
+			if (!strncmp(p, "$T", 2)) {
+				p += 2;
+				*out = "std::nullptr_t";
+				return true;
+			}
+			return fail();
+		default:
+			if ((c >= '0') && (c <= '9')) {
+				const size_t i = c - '0';
+				if (i >= types.size()) return fail();
+				*out = types[i];
+				return true;
+			}
+			return fail();
+		}
+	}
+
+	bool template_args(std::string* out) {
+		out->clear();
+		bool first = true;
+		while (*p != '@') {
+			if (!*p) return fail();
+
+			std::string arg;
+			const auto start = p;
+			if ((p[0] == '$') && (p[1] == '0')) {
+				p += 2;
+				if (!number(&arg)) return false;
+			}
+			else if (!strncmp(p, "$$V", 3) || !strncmp(p, "$$Z", 3)) {
+				//empty parameter pack
+				p += 3;
+				continue;
+			}
+			else if ((p[0] == '$') && (p[1] == 'S')) {
+				p += 2;
+				continue;
+			}
+			else {
+				if (!type(&arg)) return false;
+				//single character encodings are never memoized
+				if ((p - start > 1) && (types.size() < BACKREF_MAX)) types.push_back(arg);
+			}
+
+			if (!first) out->append(", ");
+			out->append(arg);
+			first = false;
+		}
+		++p;
+		return true;
+	}
+};
+
+extern bool msvc_demangle_type(const char* mangled, DemangledType* out) {
+	out->name.clear();
+	out->tokens.clear();
+
+	if (strncmp(mangled, ".?A", 3)) return false;
+	const char* p = mangled + 3;
+
+	switch (*p++) {
+	case 'V': out->kind = Demangled_Class; break;
+	case 'U': out->kind = Demangled_Struct; break;
+	case 'T': out->kind = Demangled_Union; break;
+	case 'W':
+		out->kind = Demangled_Enum;
+		if ((*p < '0') || (*p > '7')) return false;
+		++p;
+		break;
+	default: return false;
+	}
+
+	Demangler d{ p, {}, {}, &out->tokens, true };
+	if (!d.qualified_name(&out->name) || *d.p) {
+		out->name.clear();
+		out->tokens.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//demangler for the msvc type descriptor names found in rtti, e.g. .?AV?$SettingT@VINISettingCollection@@@@
+//covers class/struct/union/enum names, namespaces, templates, primitive, pointer and reference arguments
+//and integer template arguments; anything else makes it fail instead of guessing
+
+enum DemangledKind : uint8_t {
+	Demangled_Class,
+	Demangled_Struct,
+	Demangled_Union,
+	Demangled_Enum,
+};
+
+struct DemangledType {
+	std::string name;                //e.g. SettingT<INISettingCollection>, without the class/struct keyword
+	std::vector<std::string> tokens; //every identifier in the name: namespaces, classes and template arguments
+	DemangledKind kind;
+};
+
+//returns false if the name is not a type descriptor name or uses an unsupported encoding
+extern bool msvc_demangle_type(const char* mangled, DemangledType* out);
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "task_pool.h"
+
+//run fn(begin, end) over [0, count) split across the task pool
+template<typename Fn>
+static void parallel_chunks(size_t count, Fn fn) {
+	parallel_for(count, parallel_grain(count, 1), fn);
+}
\ No newline at end of file
@@ -1,4 +1,14 @@
 #include "process.h"
+#include "freeze.h"
+#include "text_index.h"
+#include "insn_map.h"
+#include "method_index.h"
+#include "class_hierarchy.h"
+#include "rtti_names.h"
+#include "image_sections.h"
+#include "large_pages.h"
+#include "gentle.h"
+#include "value_scan.h"
 
 #include <TlHelp32.h>
 
@@ -95,6 +105,96 @@ static uintptr_t GetProcessBaseAddress(HANDLE process) {
 	return 0;
 }
 
+extern void GetProcessMemoryBlocks(void) {
+	MEMORY_BASIC_INFORMATION mbi;
+	constexpr auto mbi_size = sizeof(mbi);
+	constexpr DWORD write_mask = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+	constexpr DWORD exec_mask = PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+	auto& blocks = GameProcessInfo.blocks;
+	blocks.clear();
+
+	for (uintptr_t address = 0; VirtualQueryEx(GameProcessInfo.process, (LPCVOID)address, &mbi, mbi_size); address += mbi.RegionSize) {
+		if (!mbi.RegionSize) break;
+		if (mbi.State != MEM_COMMIT) continue;
+		if (mbi.Protect & (PAGE_GUARD | PAGE_NOCACHE | PAGE_WRITECOMBINE | PAGE_NOACCESS)) continue;
+
+		MemoryBlock mb;
+		mb.address = address;
+		mb.size = mbi.RegionSize;
+		mb.flags = MemoryFlag_Read;
+		if (mbi.Protect & write_mask) mb.flags |= MemoryFlag_Write;
+		if (mbi.Protect & exec_mask) mb.flags |= MemoryFlag_Execute;
+		blocks.push_back(mb);
+	}
+}
+
+extern std::vector<MemoryBlock> GetScanRegions(bool writable_only, uint64_t min_size) {
+	GetProcessMemoryBlocks();
+
+	std::vector<MemoryBlock> ret;
+	for (const auto& b : GameProcessInfo.blocks) {
+		if (b.size < min_size) continue;
+		if (writable_only && !(b.flags & MemoryFlag_Write)) continue;
+		ret.push_back(b);
+	}
+	return ret;
+}
+
+extern std::vector<MemoryBlock> GetResidentRuns(const std::vector<MemoryBlock>& regions, ResidencyStats* stats) {
+	static const uint64_t page_size = 4096;
+	static const uint64_t batch_pages = 64 * 1024; //one QueryWorkingSetEx call covers 256MB
+
+	ResidencyStats local{};
+	if (!stats) stats = &local;
+	*stats = ResidencyStats{};
+
+	//an image or exe file source has no working set, everything is in the buffer
+	if (!GameProcessInfo.process) {
+		for (const auto& r : regions) stats->resident_pages += (r.size + page_size - 1) / page_size;
+		return regions;
+	}
+
+	std::vector<MemoryBlock> ret;
+	std::vector<PSAPI_WORKING_SET_EX_INFORMATION> info;
+	for (const auto& r : regions) {
+		const uintptr_t first = r.address & ~(uintptr_t)(page_size - 1);
+		const uint64_t pages = ((r.address + r.size) - first + page_size - 1) / page_size;
+
+		//runs are clipped to the region, it does not have to be page aligned
+		const uintptr_t region_end = r.address + r.size;
+		MemoryBlock run{ 0, 0, r.flags };
+		const auto flush = [&]() {
+			if (!run.size) return;
+			const auto begin = std::max(run.address, r.address);
+			const auto end = std::min(run.address + run.size, region_end);
+			ret.push_back(MemoryBlock{ begin, end - begin, r.flags });
+			run.size = 0;
+		};
+		for (uint64_t batch = 0; batch < pages; batch += batch_pages) {
+			const auto count = (size_t)std::min(batch_pages, pages - batch);
+			info.resize(count);
+			for (size_t i = 0; i < count; ++i) info[i].VirtualAddress = (PVOID)(first + (batch + i) * page_size);
+
+			//if the query fails the pages are read as before
+			const bool queried = QueryWorkingSetEx(GameProcessInfo.process, info.data(), (DWORD)(count * sizeof(info[0]))) != FALSE;
+			for (size_t i = 0; i < count; ++i) {
+				const auto page = first + (batch + i) * page_size;
+				if (queried && !info[i].VirtualAttributes.Valid) {
+					++stats->skipped_pages;
+					flush();
+					continue;
+				}
+				++stats->resident_pages;
+				if (!run.size) run.address = page;
+				run.size = page + page_size - run.address;
+			}
+		}
+		flush();
+	}
+	return ret;
+}
+
 extern MemoryBlock GetProcessBlock(const HANDLE process_handle) {
 	MemoryBlock ret = {0};
 	HMODULE base = (HMODULE) GetProcessBaseAddress(process_handle);
@@ -109,12 +209,520 @@ extern MemoryBlock GetProcessBlock(const HANDLE process_handle) {
 }
 
 
+extern void CloseGameProcess(void) {
+	//the freeze thread writes through the handle, stop it first
+	freeze_shutdown();
+	text_index_reset();
+	insn_map_reset();
+	method_index_reset();
+	class_hierarchy_reset();
+	rtti_names_reset();
+	image_sections_reset();
+	value_scan_release();
+
+	if (GameProcessInfo.process) {
+		CloseHandle(GameProcessInfo.process);
+	}
+	if (GameProcessInfo.buffer) {
+		if (GameProcessInfo.buffer_mapped) {
+			UnmapViewOfFile(GameProcessInfo.buffer);
+		}
+		else {
+			large_free(GameProcessInfo.buffer);
+		}
+	}
+
+	GameProcessInfo.process = NULL;
+	GameProcessInfo.buffer = NULL;
+	GameProcessInfo.buffer_mapped = false;
+	GameProcessInfo.buffer_size = 0;
+	GameProcessInfo.base_address = 0;
+	GameProcessInfo.proc_id = 0;
+	GameProcessInfo.rtti_map.clear();
+	GameProcessInfo.blocks.clear();
+	GameProcessInfo.exe.functions = ProcessInfo::ExeInfo::FunctionTable{};
+	GameProcessInfo.exe.pointer_slots.clear();
+}
+
+//code and read-only data are left alone by the loader, everything else is read from the process
+//(writable sections, loader written sections like .00cfg and .tls, the headers)
+extern bool is_static_section(const IMAGE_SECTION_HEADER& s) {
+	if (s.Characteristics & IMAGE_SCN_MEM_WRITE) return false;
+	return !memcmp(s.Name, ".text\0\0", 8) || !memcmp(s.Name, ".rdata\0", 8);
+}
+
+//the static sections of the module are normally identical to the exe file, map it (shared with the file cache),
+//read the other sections and the import address table from the process, and of the rest only the pages the process changed
+static bool map_module_file(const MemoryBlock& mb) {
+	char path[MAX_PATH];
+	if (!GetModuleFileNameExA(GameProcessInfo.process, (HMODULE)mb.address, path, MAX_PATH)) return false;
+
+	ProcessInfo file{};
+	if (!OpenExeFile(path, mb.address, file)) return false;
+	if (!file.buffer_mapped || (file.buffer_size != mb.size)) {
+		Log("Exe file does not match the loaded module");
+		CloseExeFile(file);
+		return false;
+	}
+
+	const auto image = (uint8_t*)file.buffer;
+	IMAGE_DOS_HEADER hdr;
+	IMAGE_NT_HEADERS64 nt;
+	memcpy(&hdr, image, sizeof(hdr));
+	memcpy(&nt, image + hdr.e_lfanew, sizeof(nt));
+	const auto sections = (const IMAGE_SECTION_HEADER*)(image + hdr.e_lfanew + offsetof(IMAGE_NT_HEADERS64, OptionalHeader) + nt.FileHeader.SizeOfOptionalHeader);
+	const auto count = nt.FileHeader.NumberOfSections;
+	const auto& iat = nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IAT];
+
+	//page ranges that come from the file, sorted by offset
+	std::vector<std::pair<uint64_t, uint64_t>> shared;
+	for (unsigned i = 0; i < count; ++i) {
+		const auto& s = sections[i];
+		if (!is_static_section(s)) continue;
+		const auto begin = (uint64_t)s.VirtualAddress;
+		const auto end = std::min<uint64_t>((begin + s.Misc.VirtualSize + 4095) & ~4095ULL, mb.size);
+
+		//the loader writes the import address table, it usually sits at the start of .rdata
+		const auto iat_begin = (uint64_t)iat.VirtualAddress & ~4095ULL;
+		const auto iat_end = ((uint64_t)iat.VirtualAddress + iat.Size + 4095) & ~4095ULL;
+		if (iat.Size && (iat_begin < end) && (iat_end > begin)) {
+			if (iat_begin > begin) shared.emplace_back(begin, iat_begin);
+			if (iat_end < end) shared.emplace_back(iat_end, end);
+		}
+		else if (begin < end) {
+			shared.emplace_back(begin, end);
+		}
+	}
+	std::sort(shared.begin(), shared.end());
+	uint64_t shared_size = 0;
+	for (const auto& r : shared) shared_size += r.second - r.first;
+	if (shared.empty()) {
+		CloseExeFile(file);
+		return false;
+	}
+
+	//hooks, patches and loader written pointers turn a copy on write page of the image private, the working set
+	//reports the shared bit for pages that are not resident as well, so only the private pages are read from the process
+	static const uint64_t batch_pages = 64 * 1024;
+	std::vector<PSAPI_WORKING_SET_EX_INFORMATION> info;
+	uint64_t bytes_read = 0;
+	uint64_t patched_size = 0;
+	for (const auto& r : shared) {
+		uint64_t patch_begin = 0, patch_end = 0; //the current run of private pages
+		bool ok = true, queried = true;
+		const auto read_patch = [&]() {
+			if (patch_end == patch_begin) return;
+			if (queried) Log("Module differs from the exe file at +%X-+%X, using the process bytes", (unsigned)patch_begin, (unsigned)patch_end);
+			ok = ok && RPM(mb.address + patch_begin, image + patch_begin, patch_end - patch_begin);
+			bytes_read += patch_end - patch_begin;
+			if (queried) patched_size += patch_end - patch_begin;
+			patch_begin = patch_end = 0;
+		};
+
+		const auto pages = (r.second - r.first) / 4096;
+		for (uint64_t batch = 0; batch < pages; batch += batch_pages) {
+			const auto count = (size_t)std::min(batch_pages, pages - batch);
+			info.resize(count);
+			for (size_t i = 0; i < count; ++i) info[i].VirtualAddress = (PVOID)(mb.address + r.first + (batch + i) * 4096);
+
+			//without the working set the pages can not be told apart, all of them are read
+			queried = QueryWorkingSetEx(GameProcessInfo.process, info.data(), (DWORD)(count * sizeof(info[0]))) != FALSE;
+			if (!queried) Log("Could not query the working set of the loaded module at +%X", (unsigned)(r.first + batch * 4096));
+			for (size_t i = 0; i < count; ++i) {
+				const auto page = r.first + (batch + i) * 4096;
+				if (queried && info[i].VirtualAttributes.Shared) {
+					read_patch();
+					continue;
+				}
+				if (patch_end != page) {
+					read_patch();
+					patch_begin = page;
+				}
+				patch_end = page + 4096;
+			}
+			read_patch();
+		}
+		if (!ok) {
+			Log("Could not read the patched pages of the loaded module");
+			CloseExeFile(file);
+			return false;
+		}
+	}
+
+	//everything between the shared ranges is read from the process
+	uint64_t pos = 0;
+	bool ok = true;
+	for (const auto& r : shared) {
+		if (ok && (r.first > pos)) {
+			ok = RPM(mb.address + pos, image + pos, r.first - pos);
+			bytes_read += r.first - pos;
+		}
+		pos = std::max(pos, r.second);
+	}
+	if (ok && (pos < mb.size)) {
+		ok = RPM(mb.address + pos, image + pos, mb.size - pos);
+		bytes_read += mb.size - pos;
+	}
+	if (!ok) {
+		CloseExeFile(file);
+		return false;
+	}
+
+	GameProcessInfo.buffer = file.buffer;
+	GameProcessInfo.buffer_mapped = true;
+	Log("Read %.1fMB from the process, %.1fMB shared with %s, %.1fMB of it patched in memory", (double)bytes_read / (1024.0 * 1024.0),
+		(double)(shared_size - patched_size) / (1024.0 * 1024.0), path, (double)patched_size / (1024.0 * 1024.0));
+	return true;
+}
+
+extern bool OpenGameProcess(DWORD procid) {
+	if (!procid) {
+		Log("procid is 0, no process selected");
+		return false;
+	}
+
+	CloseGameProcess();
+
+	Log("Scan Process ID: %u", procid);
+
+	const auto proc_handle = OpenProcess(PROCESS_ALL_ACCESS, FALSE, procid);
+	if (!proc_handle) {
+		Log("Could not open process");
+		return false;
+	}
+
+	const auto mb = GetProcessBlock(proc_handle);
+	if (!mb.address) {
+		Log("Could not get process block!");
+		return false;
+	}
+
+	GameProcessInfo.proc_id = procid;
+	GameProcessInfo.process = proc_handle;
+	GameProcessInfo.base_address = mb.address;
+	GameProcessInfo.buffer_size = mb.size;
+
+	if (map_module_file(mb)) {
+		return true;
+	}
+
+	const auto buffer = large_alloc((size_t)mb.size);
+	if (!buffer) {
+		Log("Could not allocate memory for process buffer");
+		return false;
+	}
+	GameProcessInfo.buffer = buffer;
+
+	if (!RPM(mb.address, buffer, mb.size)) {
+		Log("Could not read process memory");
+		return false;
+	}
+	
+	return true;
+}
+
+extern bool LoadImageFile(const char* path, uintptr_t base_address) {
+	CloseGameProcess();
+
+	Log("Load Image File: %s", path);
+
+	FILE* f = NULL;
+	fopen_s(&f, path, "rb");
+	if (!f) {
+		Log("Could not open image file");
+		return false;
+	}
+
+	_fseeki64(f, 0, SEEK_END);
+	const auto size = (uint64_t)_ftelli64(f);
+	_fseeki64(f, 0, SEEK_SET);
+
+	const auto buffer = large_alloc((size_t)size);
+	if (!buffer) {
+		Log("Could not allocate memory for process buffer");
+		fclose(f);
+		return false;
+	}
+
+	const auto read = fread(buffer, 1, (size_t)size, f);
+	fclose(f);
+	if (read != size) {
+		Log("Could not read image file");
+		large_free(buffer);
+		return false;
+	}
+
+	//the image must be a dump of the loaded module, not the file on disk
+	IMAGE_DOS_HEADER hdr{};
+	if (size >= sizeof(hdr)) memcpy(&hdr, buffer, sizeof(hdr));
+	if (hdr.e_magic != IMAGE_DOS_SIGNATURE) {
+		Log("Not a PE image");
+		large_free(buffer);
+		return false;
+	}
+
+	//default to the preferred image base from the optional header
+	if (!base_address) {
+		IMAGE_NT_HEADERS64 nt;
+		if ((uint64_t)hdr.e_lfanew + sizeof(nt) > size) {
+			Log("Not a PE image");
+			large_free(buffer);
+			return false;
+		}
+		memcpy(&nt, (char*)buffer + hdr.e_lfanew, sizeof(nt));
+		base_address = (uintptr_t)nt.OptionalHeader.ImageBase;
+	}
+
+	Log("Base Address %p", (void*)base_address);
+
+	GameProcessInfo.base_address = base_address;
+	GameProcessInfo.buffer_size = size;
+	GameProcessInfo.buffer = buffer;
+	return true;
+}
+
+//add delta to every IMAGE_REL_BASED_DIR64 slot, returns the first slot or 0 if there are none
+static uint32_t relocate_image(uint8_t* image, uint64_t image_size, uint32_t reloc_offset, uint32_t reloc_size, int64_t delta) {
+	uint32_t first = 0;
+	if (!reloc_offset || ((uint64_t)reloc_offset + reloc_size > image_size)) return first;
+
+	uint32_t pos = 0;
+	while (pos + sizeof(IMAGE_BASE_RELOCATION) <= reloc_size) {
+		IMAGE_BASE_RELOCATION block;
+		memcpy(&block, image + reloc_offset + pos, sizeof(block));
+		if ((block.SizeOfBlock < sizeof(block)) || (block.SizeOfBlock > reloc_size - pos)) break;
+
+		const auto entries = (const uint16_t*)(image + reloc_offset + pos + sizeof(block));
+		const auto count = (block.SizeOfBlock - sizeof(block)) / sizeof(uint16_t);
+		for (size_t i = 0; i < count; ++i) {
+			if ((entries[i] >> 12) != IMAGE_REL_BASED_DIR64) continue;
+			const uint32_t slot = block.VirtualAddress + (entries[i] & 0xFFF);
+			if ((uint64_t)slot + sizeof(uint64_t) > image_size) continue;
+			if (!first) first = slot;
+			if (!delta) return first;
+
+			uint64_t value;
+			memcpy(&value, image + slot, sizeof(value));
+			value += delta;
+			memcpy(image + slot, &value, sizeof(value));
+		}
+		pos += block.SizeOfBlock;
+	}
+	return first;
+}
+
+//file offset of an image offset, 0 if it is not backed by section data
+static uint64_t image_to_file_offset(const IMAGE_SECTION_HEADER* sections, unsigned count, uint32_t offset) {
+	for (unsigned i = 0; i < count; ++i) {
+		const auto& s = sections[i];
+		if ((offset >= s.VirtualAddress) && (offset - s.VirtualAddress < s.SizeOfRawData)) {
+			return (uint64_t)s.PointerToRawData + (offset - s.VirtualAddress);
+		}
+	}
+	return 0;
+}
+
+//the kernel lays out SEC_IMAGE views itself, read-only sections are shared with the file cache
+//and copy-on-write only duplicates the pages that relocation (or a WPM) writes to
+static void* map_exe_image(HANDLE file, uint64_t image_size) {
+	auto mapping = CreateFileMappingA(file, NULL, PAGE_READONLY | SEC_IMAGE_NO_EXECUTE, 0, 0, NULL);
+	if (!mapping) mapping = CreateFileMappingA(file, NULL, PAGE_READONLY | SEC_IMAGE, 0, 0, NULL);
+	if (!mapping) return NULL;
+
+	//the view holds a reference to the mapping
+	const auto view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view) return NULL;
+
+	//image pages keep their section protection, writes need copy-on-write access
+	DWORD old;
+	if (!VirtualProtect(view, (SIZE_T)image_size, PAGE_WRITECOPY, &old)) {
+		UnmapViewOfFile(view);
+		return NULL;
+	}
+	return view;
+}
+
+//fallback when the file cannot be mapped as an image, e.g. it fails the loader checks
+static void* copy_exe_image(const uint8_t* file_data, uint64_t file_size, const IMAGE_NT_HEADERS64& nt, const IMAGE_SECTION_HEADER* sections) {
+	const uint64_t image_size = nt.OptionalHeader.SizeOfImage;
+	const auto image = (uint8_t*)large_alloc((size_t)image_size);
+	if (!image) return NULL;
+
+	memcpy(image, file_data, (size_t)std::min<uint64_t>(nt.OptionalHeader.SizeOfHeaders, std::min(file_size, image_size)));
+	for (unsigned i = 0; i < nt.FileHeader.NumberOfSections; ++i) {
+		const auto& s = sections[i];
+		if ((s.PointerToRawData >= file_size) || (s.VirtualAddress >= image_size)) continue;
+		auto size = std::min<uint64_t>(s.SizeOfRawData, file_size - s.PointerToRawData);
+		size = std::min<uint64_t>(size, image_size - s.VirtualAddress);
+		memcpy(image + s.VirtualAddress, file_data + s.PointerToRawData, (size_t)size);
+	}
+	return image;
+}
+
+extern bool LoadExeFile(const char* path, uintptr_t base_address) {
+	CloseGameProcess();
+	return OpenExeFile(path, base_address, GameProcessInfo);
+}
+
+extern bool OpenExeFile(const char* path, uintptr_t base_address, ProcessInfo& p) {
+	Log("Load Exe File: %s", path);
+
+	const auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		Log("Could not open exe file");
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	const auto raw_mapping = GetFileSizeEx(file, &size) ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	const auto raw = raw_mapping ? (const uint8_t*)MapViewOfFile(raw_mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (raw_mapping) CloseHandle(raw_mapping);
+	if (!raw) {
+		Log("Could not map exe file");
+		CloseHandle(file);
+		return false;
+	}
+	const auto file_size = (uint64_t)size.QuadPart;
+
+	bool ok = false;
+	IMAGE_DOS_HEADER hdr{};
+	IMAGE_NT_HEADERS64 nt{};
+	const IMAGE_SECTION_HEADER* sections = NULL;
+	void* image = NULL;
+	bool mapped = false;
+
+	if (file_size >= sizeof(hdr)) memcpy(&hdr, raw, sizeof(hdr));
+	if ((hdr.e_magic == IMAGE_DOS_SIGNATURE) && (hdr.e_lfanew > 0) && ((uint64_t)hdr.e_lfanew + sizeof(nt) <= file_size)) {
+		memcpy(&nt, raw + hdr.e_lfanew, sizeof(nt));
+		const auto first_section = (uint64_t)hdr.e_lfanew + offsetof(IMAGE_NT_HEADERS64, OptionalHeader) + nt.FileHeader.SizeOfOptionalHeader;
+		if ((first_section + nt.FileHeader.NumberOfSections * sizeof(IMAGE_SECTION_HEADER)) <= file_size) {
+			sections = (const IMAGE_SECTION_HEADER*)(raw + first_section);
+		}
+	}
+	if (!sections || (nt.Signature != IMAGE_NT_SIGNATURE) || (nt.OptionalHeader.Magic != IMAGE_NT_OPTIONAL_HDR64_MAGIC)) {
+		Log("Not a 64 bit PE file");
+		goto CLEANUP;
+	}
+
+	image = map_exe_image(file, nt.OptionalHeader.SizeOfImage);
+	mapped = (image != NULL);
+	if (!image) {
+		Log("Could not map the file as an image, copying sections instead");
+		image = copy_exe_image(raw, file_size, nt, sections);
+	}
+	if (!image) {
+		Log("Could not allocate memory for process buffer");
+		goto CLEANUP;
+	}
+
+	{
+		if (!base_address) base_address = (uintptr_t)nt.OptionalHeader.ImageBase;
+		const auto image_size = (uint64_t)nt.OptionalHeader.SizeOfImage;
+		const auto& dir = nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+
+		//a SEC_IMAGE view may already be relocated by the kernel, compare a slot with the file
+		//to find the base its pointers are for, then move them to base_address
+		uint64_t current_base = nt.OptionalHeader.ImageBase;
+		const auto slot = relocate_image((uint8_t*)image, image_size, dir.VirtualAddress, dir.Size, 0);
+		const auto file_offset = slot ? image_to_file_offset(sections, nt.FileHeader.NumberOfSections, slot) : 0;
+		if (file_offset && (file_offset + sizeof(uint64_t) <= file_size)) {
+			uint64_t in_file, in_image;
+			memcpy(&in_file, raw + file_offset, sizeof(in_file));
+			memcpy(&in_image, (const uint8_t*)image + slot, sizeof(in_image));
+			current_base += (in_image - in_file);
+		}
+		if (!slot && (base_address != nt.OptionalHeader.ImageBase)) {
+			Log("Exe file has no relocations, pointers stay at %p", (void*)nt.OptionalHeader.ImageBase);
+		}
+		relocate_image((uint8_t*)image, image_size, dir.VirtualAddress, dir.Size, (int64_t)(base_address - current_base));
+
+		Log("Base Address %p (%s)", (void*)base_address, mapped ? "image view" : "copied sections");
+
+		p.base_address = base_address;
+		p.buffer_size = image_size;
+		p.buffer = image;
+		p.buffer_mapped = mapped;
+		ok = true;
+	}
+
+	CLEANUP:
+	UnmapViewOfFile(raw);
+	CloseHandle(file);
+	return ok;
+}
+
+extern void CloseExeFile(ProcessInfo& p) {
+	if (p.buffer) {
+		if (p.buffer_mapped) {
+			UnmapViewOfFile(p.buffer);
+		}
+		else {
+			large_free(p.buffer);
+		}
+	}
+	p = ProcessInfo{};
+}
+
+extern bool SaveImageFile(const char* path) {
+	if (!GameProcessInfo.buffer) {
+		Log("No image loaded");
+		return false;
+	}
+
+	FILE* f = NULL;
+	fopen_s(&f, path, "wb");
+	if (!f) {
+		Log("Could not open %s for writing", path);
+		return false;
+	}
+	const auto written = fwrite(GameProcessInfo.buffer, 1, (size_t)GameProcessInfo.buffer_size, f);
+	fclose(f);
+	return (written == GameProcessInfo.buffer_size);
+}
+
+//strings are read a page at a time, most are a few bytes long and a single read of
+//max_size bytes fails whenever it crosses into an unmapped page
+extern std::string ReadGameString(uintptr_t address, uint32_t max_size) {
+	std::string ret;
+	char buffer[4096];
+	while (ret.size() < max_size - 1) {
+		const auto at = address + ret.size();
+		auto chunk = (uint32_t)(4096 - (at & 4095));
+		if (chunk > max_size - 1 - ret.size()) chunk = (uint32_t)(max_size - 1 - ret.size());
+		if (!RPM(at, buffer, chunk)) break;
+		const auto nul = (const char*)memchr(buffer, 0, chunk);
+		ret.append(buffer, nul ? (nul - buffer) : chunk);
+		if (nul) break;
+	}
+	return ret;
+}
+
+//without a process handle the image buffer is the only memory source (see LoadImageFile)
+static bool in_image(uintptr_t address, uint64_t size) {
+	const auto offset = address - GameProcessInfo.base_address;
+	return (address >= GameProcessInfo.base_address) && (offset < GameProcessInfo.buffer_size) && (size <= GameProcessInfo.buffer_size - offset);
+}
+
 extern bool RPM(uintptr_t address, void* buffer, uint64_t read_size) {
 	const auto proc = GameProcessInfo.process;
-	assert(proc != NULL);
-	SIZE_T bytes_read;
-	BOOL result = ReadProcessMemory(proc, (LPCVOID)address, (LPVOID)buffer, (SIZE_T)read_size, &bytes_read);
-	const auto ret = (result && (read_size == bytes_read));
+	if (!proc) {
+		if (!in_image(address, read_size)) {
+			Log("RPM Failed: %p", address);
+			return false;
+		}
+		memcpy(buffer, (char*)GameProcessInfo.buffer + (address - GameProcessInfo.base_address), (size_t)read_size);
+		return true;
+	}
+	//gentle mode hands out large reads in paced pieces, otherwise this is a single read
+	bool ret = true;
+	for (uint64_t pos = 0; ret && (pos < read_size); ) {
+		const auto size = gentle_acquire(read_size - pos);
+		SIZE_T bytes_read;
+		BOOL result = ReadProcessMemory(proc, (LPCVOID)(address + pos), (LPVOID)((char*)buffer + pos), (SIZE_T)size, &bytes_read);
+		ret = (result && (size == bytes_read));
+		pos += size;
+	}
 	if (!ret) {
 		Log("RPM Failed: %p", address);
 	}
@@ -123,7 +731,14 @@ extern bool RPM(uintptr_t address, void* buffer, uint64_t read_size) {
 
 extern bool WPM(uintptr_t address, void* buffer, uint64_t write_size) {
 	const auto proc = GameProcessInfo.process;
-	assert(proc != NULL);
+	if (!proc) {
+		if (!in_image(address, write_size)) {
+			Log("WPM Failed: %p", address);
+			return false;
+		}
+		memcpy((char*)GameProcessInfo.buffer + (address - GameProcessInfo.base_address), buffer, (size_t)write_size);
+		return true;
+	}
 	SIZE_T bytes_written;
 	BOOL result = WriteProcessMemory(proc, (LPVOID)address, (LPCVOID)buffer, (SIZE_T)write_size, &bytes_written);
 	const auto ret = (result && (write_size == bytes_written));
@@ -5,6 +5,34 @@
 extern DWORD GetProcessIdByWindowTitle(const wchar_t* window_title);
 extern DWORD GetProcessIdByExeName(const char* exe_name);
 extern void GetProcessMemoryBlocks(void);
+extern std::vector<MemoryBlock> GetScanRegions(bool writable_only, uint64_t min_size);
 extern MemoryBlock GetProcessBlock(const HANDLE process_handle);
+
+struct ResidencyStats {
+	uint64_t resident_pages;
+	uint64_t skipped_pages; //paged out or never touched
+};
+//the runs of the regions' pages that are in the game's working set, in region order
+//a scan of the runs does not see pages that are paged out (reading would fault them back in) or were never touched (all zero),
+//so a value that only exists on such a page is not found
+extern std::vector<MemoryBlock> GetResidentRuns(const std::vector<MemoryBlock>& regions, ResidencyStats* stats);
+
+//open the process and copy its main module into GameProcessInfo.buffer
+extern bool OpenGameProcess(DWORD procid);
+//load a raw dump of the loaded module instead of attaching, RPM/WPM then operate on the buffer
+//a base_address of 0 uses the image base from the pe header
+extern bool LoadImageFile(const char* path, uintptr_t base_address);
+//map an exe file from disk (e.g. an archived build) in image layout and relocate it for base_address
+//untouched pages stay shared with the file, a base_address of 0 uses the image base from the pe header
+extern bool LoadExeFile(const char* path, uintptr_t base_address);
+//same into a ProcessInfo of its own (see batch.cpp), release with CloseExeFile
+extern bool OpenExeFile(const char* path, uintptr_t base_address, ProcessInfo& p);
+extern void CloseExeFile(ProcessInfo& p);
+//.text and .rdata, the sections OpenGameProcess maps from the exe file instead of reading them
+extern bool is_static_section(const IMAGE_SECTION_HEADER& s);
+extern bool SaveImageFile(const char* path);
+extern void CloseGameProcess(void);
 extern bool RPM(uintptr_t address, void* buffer, uint64_t read_size);
-extern bool WPM(uintptr_t address, void* buffer, uint64_t write_size);
\ No newline at end of file
+extern bool WPM(uintptr_t address, void* buffer, uint64_t write_size);
+//read a nul terminated string of at most max_size - 1 characters
+extern std::string ReadGameString(uintptr_t address, uint32_t max_size);
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "profile.h"
+
+static char* trim(char* s) {
+	while (::isspace((unsigned char)*s)) ++s;
+	auto e = s + strlen(s);
+	while ((e > s) && ::isspace((unsigned char)e[-1])) --e;
+	*e = '\0';
+	return s;
+}
+
+static void to_lower(std::string& s) {
+	for (auto& c : s) c = (char)::tolower((unsigned char)c);
+}
+
+extern bool profile_load(const char* path, std::vector<ProfileEntry>& entries) {
+	entries.clear();
+
+	FILE* f = NULL;
+	fopen_s(&f, path, "rb");
+	if (!f) {
+		Log("Could not open profile %s", path);
+		return false;
+	}
+
+	std::string section;
+	uint32_t line_nr = 0;
+	char line[1024];
+	while (fgets(line, sizeof(line), f)) {
+		++line_nr;
+		auto text = trim(line);
+
+		//utf-8 bom
+		if ((line_nr == 1) && !strncmp(text, "\xEF\xBB\xBF", 3)) text = trim(text + 3);
+		if (!*text || (*text == '#') || (*text == ';')) continue;
+
+		if (*text == '[') {
+			const auto close = strchr(text, ']');
+			if (!close) {
+				Log("%s:%u: unterminated section", path, line_nr);
+				continue;
+			}
+			*close = '\0';
+			section = trim(text + 1);
+			to_lower(section);
+			continue;
+		}
+
+		const auto eq = strchr(text, '=');
+		if (!eq) {
+			Log("%s:%u: expected name=value", path, line_nr);
+			continue;
+		}
+		*eq = '\0';
+
+		ProfileEntry e;
+		e.key = trim(text);
+		to_lower(e.key);
+		if (!section.empty()) {
+			e.key += ':';
+			e.key += section;
+		}
+		e.value = trim(eq + 1);
+		e.line = line_nr;
+		entries.push_back(std::move(e));
+	}
+
+	fclose(f);
+	return true;
+}
+
+static bool by_address(const SettingWrite& a, const SettingWrite& b) {
+	return a.address < b.address;
+}
+
+extern ProfileResult profile_apply(const std::vector<ProfileEntry>& entries, std::vector<Setting>& settings, ProfileTransaction* txn) {
+	ProfileResult r{};
+	r.entries = (uint32_t)entries.size();
+
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	std::unordered_map<std::string, uint32_t> index;
+	index.reserve(settings.size());
+	for (uint32_t i = 0; i < (uint32_t)settings.size(); ++i) {
+		index.emplace(settings[i].m_search_name, i);
+	}
+
+	struct Pending {
+		SettingWrite write;
+		uint32_t setting;
+	};
+	std::vector<Pending> pending;
+	pending.reserve(entries.size());
+
+	for (const auto& e : entries) {
+		const auto found = index.find(e.key);
+		if (found == index.end()) {
+			Log("Profile line %u: unknown setting %s", e.line, e.key.c_str());
+			++r.unknown;
+			continue;
+		}
+
+		const auto& s = settings[found->second];
+		//strings would need memory in the game and unknown types have no parser
+		const auto type = Setting::GetGameSettingType(s.m_name[0]);
+		if (type & (GameSettingFlag::TypeString | GameSettingFlag::TypeUnknown)) {
+			Log("Profile line %u: %s settings can not be applied (%s)", e.line, Setting::GetGameSettingTypeName(type), s.m_name.c_str());
+			++r.unsupported;
+			continue;
+		}
+
+		Pending p{};
+		p.setting = found->second;
+		p.write.address = s.m_address;
+		p.write.expected = s.m_setting;
+		p.write.value = s.m_active;
+		if (!Setting::ParseValue(e.value.c_str(), s.m_flags, &p.write.value)) {
+			Log("Profile line %u: invalid %s value for %s", e.line, Setting::GetGameSettingTypeName(s.m_flags), s.m_name.c_str());
+			++r.invalid;
+			continue;
+		}
+		pending.push_back(p);
+	}
+
+	//the last assignment of a setting wins
+	std::stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) { return by_address(a.write, b.write); });
+	std::vector<SettingWrite> writes;
+	std::vector<uint32_t> owners;
+	writes.reserve(pending.size());
+	owners.reserve(pending.size());
+	for (size_t i = 0; i < pending.size(); ++i) {
+		if ((i + 1 < pending.size()) && (pending[i + 1].write.address == pending[i].write.address)) continue;
+		writes.push_back(pending[i].write);
+		owners.push_back(pending[i].setting);
+	}
+
+	r.batch = Setting::UpdateBatch(writes.data(), writes.size());
+
+	if (txn) txn->undo.clear();
+	for (size_t i = 0; i < writes.size(); ++i) {
+		const auto& w = writes[i];
+		if (w.status == SettingWrite_Unchanged) {
+			++r.unchanged;
+			continue;
+		}
+		if (w.status != SettingWrite_Written) {
+			Log("Profile: could not apply %s", settings[owners[i]].m_name.c_str());
+			++r.failed;
+			continue;
+		}
+
+		++r.written;
+		auto& s = settings[owners[i]];
+		s.m_active = w.value;
+		s.m_current = w.value;
+		s.m_flags |= GameSettingFlag::FlagChanged;
+
+		if (txn) {
+			//only restored while the setting still holds the applied value
+			SettingWrite undo = w;
+			undo.value = w.previous;
+			undo.previous = w.value;
+			undo.expected.Active = w.value;
+			undo.check_active = true;
+			txn->undo.push_back(undo);
+		}
+	}
+
+	QueryPerformanceCounter(&end);
+	r.elapsed_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+	Log("Profile: %u entries, %u written, %u unchanged, %u unknown, %u unsupported, %u invalid, %u failed in %.2fms (%u reads, %u writes)",
+		r.entries, r.written, r.unchanged, r.unknown, r.unsupported, r.invalid, r.failed, r.elapsed_ms, r.batch.reads, r.batch.writes);
+	return r;
+}
+
+extern SettingBatchStats profile_rollback(ProfileTransaction& txn, std::vector<Setting>& settings) {
+	const auto stats = Setting::UpdateBatch(txn.undo.data(), txn.undo.size());
+
+	std::unordered_map<uintptr_t, uint32_t> by_addr;
+	by_addr.reserve(settings.size());
+	for (uint32_t i = 0; i < (uint32_t)settings.size(); ++i) {
+		by_addr.emplace(settings[i].m_address, i);
+	}
+
+	for (const auto& w : txn.undo) {
+		if ((w.status != SettingWrite_Written) && (w.status != SettingWrite_Unchanged)) continue;
+		const auto found = by_addr.find(w.address);
+		if (found == by_addr.end()) continue;
+		auto& s = settings[found->second];
+		s.m_active = w.value;
+		s.m_current = w.value;
+	}
+
+	uint32_t kept = 0;
+	for (const auto& w : txn.undo) {
+		if (w.status == SettingWrite_ValueChanged) ++kept;
+	}
+	Log("Profile rollback: %u restored, %u changed since the apply and kept, %u failed", stats.written, kept, stats.failed - kept);
+	txn.undo.clear();
+	return stats;
+}
\ No newline at end of file
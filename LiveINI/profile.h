@@ -0,0 +1,41 @@
+#pragma once
+
+#include "setting.h"
+
+//ini style settings profiles
+//  [Section]
+//  name=value        ; applies to the setting "name:Section"
+//lines before the first section name the setting in full, e.g. fFoo:Display=1.0
+
+struct ProfileEntry {
+	std::string key;   //lowercase name:section, matches Setting::m_search_name
+	std::string value;
+	uint32_t line;
+};
+
+struct ProfileResult {
+	uint32_t entries;
+	uint32_t written;
+	uint32_t unchanged;
+	uint32_t unknown;       //no setting with that name
+	uint32_t unsupported;   //string and unknown typed settings
+	uint32_t invalid;       //value could not be parsed for the setting type
+	uint32_t failed;        //guard check, read or write failed
+	SettingBatchStats batch;
+	double elapsed_ms;
+};
+
+//everything needed to undo an applied profile
+struct ProfileTransaction {
+	std::vector<SettingWrite> undo; //sorted by address, value is the active value before the profile
+};
+
+extern bool profile_load(const char* path, std::vector<ProfileEntry>& entries);
+
+/// apply all entries to the matching settings with one guarded batch write
+/// written settings are recorded in txn (if not null) and updated in settings
+extern ProfileResult profile_apply(const std::vector<ProfileEntry>& entries, std::vector<Setting>& settings, ProfileTransaction* txn);
+
+/// restore the values recorded by profile_apply
+/// a setting is only restored while its active value is still the one the profile wrote, later changes by the user or the game are kept
+extern SettingBatchStats profile_rollback(ProfileTransaction& txn, std::vector<Setting>& settings);
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "rtti_names.h"
+#include "parallel.h"
+
+static struct {
+	std::vector<RttiName> names;
+	std::vector<char> arena;
+	std::vector<uint32_t> class_tokens;  //token ids of every class, see RttiName::first_token
+	std::vector<uint32_t> token_string;  //arena offset of each lowercase token, sorted by string
+	std::vector<uint32_t> token_begin;   //classes with token t are token_classes[token_begin[t] .. token_begin[t + 1])
+	std::vector<uint32_t> token_classes;
+	uint32_t generation;
+} Names{};
+
+static uint32_t arena_add(const std::string& s) {
+	const auto offset = (uint32_t)Names.arena.size();
+	Names.arena.insert(Names.arena.end(), s.begin(), s.end());
+	Names.arena.push_back('\0');
+	return offset;
+}
+
+static std::string to_lower(const std::string& s) {
+	std::string ret{ s };
+	for (auto& c : ret) c = (char)::tolower((unsigned char)c);
+	return ret;
+}
+
+extern void rtti_names_reset(void) {
+	Names.names = std::vector<RttiName>{};
+	Names.arena = std::vector<char>{};
+	Names.class_tokens = std::vector<uint32_t>{};
+	Names.token_string = std::vector<uint32_t>{};
+	Names.token_begin = std::vector<uint32_t>{};
+	Names.token_classes = std::vector<uint32_t>{};
+	++Names.generation;
+}
+
+extern void rtti_names_build(void) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	rtti_names_reset();
+
+	std::vector<const char*> mangled;
+	mangled.reserve(GameProcessInfo.rtti_map.size());
+	for (const auto& x : GameProcessInfo.rtti_map) mangled.push_back(x.second.name);
+	std::sort(mangled.begin(), mangled.end(), [](const char* a, const char* b) { return strcmp(a, b) < 0; });
+
+	std::vector<DemangledType> demangled(mangled.size());
+	std::vector<uint8_t> ok(mangled.size());
+	parallel_chunks(mangled.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) ok[i] = msvc_demangle_type(mangled[i], &demangled[i]);
+	});
+
+	//readable and lowercase names first, then every distinct token once
+	std::vector<std::pair<std::string, uint32_t>> token_refs; //(lowercase token, class id)
+	Names.names.resize(mangled.size());
+	for (uint32_t id = 0; id < mangled.size(); ++id) {
+		auto& n = Names.names[id];
+		const auto& d = demangled[id];
+		const auto& readable = ok[id] ? d.name : std::string{ mangled[id] };
+
+		n.mangled = mangled[id];
+		n.readable = arena_add(readable);
+		n.lower = arena_add(to_lower(readable));
+		n.kind = d.kind;
+		n.demangled = ok[id] != 0;
+		for (const auto& t : d.tokens) token_refs.emplace_back(to_lower(t), id);
+	}
+	std::sort(token_refs.begin(), token_refs.end());
+
+	std::vector<uint32_t> ref_token(token_refs.size());
+	for (size_t i = 0; i < token_refs.size(); ++i) {
+		if (!i || (token_refs[i].first != token_refs[i - 1].first)) {
+			Names.token_string.push_back(arena_add(token_refs[i].first));
+			Names.token_begin.push_back((uint32_t)i);
+		}
+		ref_token[i] = (uint32_t)Names.token_string.size() - 1;
+		Names.token_classes.push_back(token_refs[i].second);
+	}
+	Names.token_begin.push_back((uint32_t)token_refs.size());
+
+	//per class token lists, the same refs grouped by class instead of by token
+	std::vector<uint32_t> per_class(Names.names.size() + 1);
+	for (const auto& r : token_refs) ++per_class[r.second + 1];
+	for (size_t i = 0; i < Names.names.size(); ++i) {
+		per_class[i + 1] += per_class[i];
+		Names.names[i].first_token = per_class[i];
+		Names.names[i].token_count = per_class[i + 1] - per_class[i];
+	}
+	Names.class_tokens.resize(token_refs.size());
+	for (size_t i = 0; i < token_refs.size(); ++i) {
+		Names.class_tokens[per_class[token_refs[i].second]++] = ref_token[i];
+	}
+
+	size_t failed = 0;
+	for (const auto x : ok) failed += !x;
+
+	QueryPerformanceCounter(&end);
+	Log("RTTI names: %u demangled (%u kept mangled), %u tokens, %uKB arena, %.2fms",
+		(unsigned)(Names.names.size() - failed), (unsigned)failed, (unsigned)Names.token_string.size(),
+		(unsigned)(Names.arena.size() / 1024), (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart);
+}
+
+extern size_t rtti_names_count(void) {
+	return Names.names.size();
+}
+
+extern uint32_t rtti_names_generation(void) {
+	return Names.generation;
+}
+
+extern const RttiName& rtti_name(uint32_t id) {
+	return Names.names[id];
+}
+
+extern const char* rtti_names_string(uint32_t offset) {
+	return Names.arena.data() + offset;
+}
+
+extern uint32_t rtti_token_find(const char* token) {
+	std::string lower{ token };
+	for (auto& c : lower) c = (char)::tolower((unsigned char)c);
+
+	const auto it = std::lower_bound(Names.token_string.begin(), Names.token_string.end(), lower,
+		[](uint32_t offset, const std::string& s) { return strcmp(rtti_names_string(offset), s.c_str()) < 0; });
+	if ((it == Names.token_string.end()) || strcmp(rtti_names_string(*it), lower.c_str())) return RTTI_TOKEN_NONE;
+	return (uint32_t)(it - Names.token_string.begin());
+}
+
+extern size_t rtti_token_classes(uint32_t token, const uint32_t** first) {
+	*first = Names.token_classes.data() + Names.token_begin[token];
+	return Names.token_begin[token + 1] - Names.token_begin[token];
+}
+
+extern const char* rtti_token_string(uint32_t token) {
+	return rtti_names_string(Names.token_string[token]);
+}
+
+extern size_t rtti_class_tokens(uint32_t id, const uint32_t** first) {
+	*first = Names.class_tokens.data() + Names.names[id].first_token;
+	return Names.names[id].token_count;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "main.h"
+#include "msvc_demangle.h"
+
+//demangled rtti names and a token index over them, built once per scan
+//every demangled and lowercase string lives in one arena, ids follow the mangled names in sorted order
+
+struct RttiName {
+	const char* mangled;  //rtti_map name, points into the image buffer
+	uint32_t readable;    //arena offset of the demangled name, the mangled name is copied if it could not be demangled
+	uint32_t lower;       //arena offset of the lowercase readable name, for case insensitive search
+	uint32_t first_token; //token ids of this class are tokens[first_token .. first_token + token_count)
+	uint32_t token_count;
+	DemangledKind kind;
+	bool demangled;
+};
+
+constexpr uint32_t RTTI_TOKEN_NONE = UINT32_MAX;
+
+//demangle every rtti_map name on all cores, call after turbo_vtable_algorithm
+extern void rtti_names_build(void);
+extern void rtti_names_reset(void);
+
+extern size_t rtti_names_count(void);
+//changes whenever the names are built or reset, for lists derived from them
+extern uint32_t rtti_names_generation(void);
+extern const RttiName& rtti_name(uint32_t id);
+extern const char* rtti_names_string(uint32_t offset);
+
+//token id of a namespace, class or template argument name, case insensitive
+extern uint32_t rtti_token_find(const char* token);
+extern const char* rtti_token_string(uint32_t token);
+
+//token ids of one class, first is set to the start of the range
+extern size_t rtti_class_tokens(uint32_t id, const uint32_t** first);
+
+/// every class id whose name contains the token, sorted, first is set to the start of the range
+extern size_t rtti_token_classes(uint32_t token, const uint32_t** first);
\ No newline at end of file
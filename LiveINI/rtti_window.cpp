@@ -1,48 +1,184 @@
 #include "main.h"
 #include "rtti_window.h"
 #include "memory_scan.h"
+#include "class_correlate.h"
+#include "class_hierarchy.h"
+#include "rtti_names.h"
 
 extern "C" {
 #include "minilibs/regexp.h"
 }
 
 struct RTTIDetail {
-        std::string name;
-        std::string search_name;
-        uintptr_t vtable_ptr;
-        unsigned offset;
+        uint32_t id; //rtti_names id
         bool match;
 };
 
 
+static void draw_migration() {
+        static AnalysisCache current{};
+        static AnalysisCache older{};
+        static ClassCorrelation correlation{};
+        static char old_path[MAX_PATH] = "analysis_cache/";
+        static char offset_text[32];
+        static char migrated_text[512];
+
+        if (ImGui::Button("Save analysis for this version")) {
+                analysis_capture(current);
+                const auto path = analysis_cache_path(current.version);
+                if (analysis_cache_save(current, path.c_str())) {
+                        Log("Saved %s", path.c_str());
+                }
+        }
+
+        ImGui::InputText("Old analysis", old_path, sizeof(old_path));
+        ImGui::SameLine();
+        if (ImGui::Button("Correlate")) {
+                correlation.rows.clear();
+                if (analysis_cache_load(older, old_path)) {
+                        analysis_capture(current);
+                        correlate_classes(older, current, correlation);
+                }
+        }
+
+        if (correlation.rows.empty()) return;
+
+        const auto& vo = older.version;
+        const auto& vn = current.version;
+        ImGui::Text("%u.%u.%u.%u -> %u.%u.%u.%u: %u by name, %u by fingerprint, %u removed, %u added (%.2fms)",
+                vo.major, vo.minor, vo.build, vo.revision,
+                vn.major, vn.minor, vn.build, vn.revision,
+                correlation.counts[ClassMatch_Name],
+                correlation.counts[ClassMatch_Fingerprint],
+                correlation.counts[ClassMatch_Removed],
+                correlation.counts[ClassMatch_Added],
+                correlation.elapsed_ms);
+
+        if (ImGui::InputText("Migrate Starfield.exe+", offset_text, sizeof(offset_text), ImGuiInputTextFlags_CharsHexadecimal)) {
+                uint32_t new_rva = 0;
+                std::string how;
+                const auto old_rva = (uint32_t)strtoul(offset_text, NULL, 16);
+                if (migrate_offset(older, current, correlation, old_rva, &new_rva, &how)) {
+                        snprintf(migrated_text, sizeof(migrated_text), "Starfield.exe+%X -> Starfield.exe+%X, %s", old_rva, new_rva, how.c_str());
+                }
+                else {
+                        snprintf(migrated_text, sizeof(migrated_text), "Starfield.exe+%X is not part of a correlated vtable", old_rva);
+                }
+        }
+        ImGui::InputText("Migrated", migrated_text, sizeof(migrated_text), ImGuiInputTextFlags_ReadOnly);
+
+        const auto flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable;
+        if (!ImGui::BeginTable("migration_table", 5, flags, ImVec2{ 0.f, 300.f })) return;
+
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Match");
+        ImGui::TableSetupColumn("Class");
+        ImGui::TableSetupColumn("Old Offset");
+        ImGui::TableSetupColumn("New Offset");
+        ImGui::TableSetupColumn("Same Methods");
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clip;
+        clip.Begin((int)correlation.rows.size());
+        while (clip.Step()) {
+                for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
+                        const auto& row = correlation.rows[i];
+                        const auto oc = (row.old_class != UINT32_MAX) ? &older.classes[row.old_class] : nullptr;
+                        const auto nc = (row.new_class != UINT32_MAX) ? &current.classes[row.new_class] : nullptr;
+
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(class_match_name(row.match));
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(nc ? nc->name.c_str() : oc->name.c_str());
+                        ImGui::TableNextColumn();
+                        if (oc) ImGui::Text("%X", oc->vtable_offset);
+                        ImGui::TableNextColumn();
+                        if (nc) ImGui::Text("%X", nc->vtable_offset);
+                        ImGui::TableNextColumn();
+                        if (oc && nc) ImGui::Text("%u / %u", row.same_methods, oc->func_count);
+                }
+        }
+        ImGui::EndTable();
+}
+
+static void draw_hierarchy(const char* name) {
+        const auto& h = class_hierarchy();
+        const auto id = hierarchy_find(h, name);
+        if (id == HIERARCHY_NONE) return;
+
+        const uint32_t* ids;
+        const auto bases = hierarchy_bases(h, id, &ids);
+        for (size_t i = 0; i < bases; ++i) {
+                ImGui::Text("Base: %s", h.names[ids[i]].c_str());
+        }
+
+        const auto derived = hierarchy_derived(h, id, &ids);
+        if (!derived) return;
+
+        char label[64];
+        snprintf(label, sizeof(label), "Derived classes (%u)", (unsigned)derived);
+        if (ImGui::TreeNode(label)) {
+                for (size_t i = 0; i < derived; ++i) {
+                        ImGui::TextUnformatted(h.names[ids[i]].c_str());
+                }
+                ImGui::TreePop();
+        }
+
+        if (ImGui::TreeNode("All subclasses")) {
+                static uint32_t cached_generation = 0;
+                static uint32_t cached_id = HIERARCHY_NONE;
+                static std::vector<uint32_t> subclasses;
+                if ((cached_id != id) || (class_hierarchy_generation() != cached_generation)) {
+                        hierarchy_subclasses(h, id, subclasses);
+                        cached_id = id;
+                        cached_generation = class_hierarchy_generation();
+                }
+
+                ImGui::Text("%u subclasses", (unsigned)subclasses.size());
+                ImGuiListClipper clip;
+                clip.Begin((int)subclasses.size());
+                while (clip.Step()) {
+                        for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
+                                ImGui::TextUnformatted(h.names[subclasses[i]].c_str());
+                        }
+                }
+                ImGui::TreePop();
+        }
+}
+
 void draw_rtti_window() {
         static char searchbuffer[128];
+        static char tokenbuffer[64];
         static std::vector<RTTIDetail> rtti;
+        static size_t result_count = 0;
+        static uint32_t names_generation = 0;
 
         if (!GameProcessInfo.rtti_map.size()) {
                 ImGui::Text("Press Scan Starfield in the log window");
                 return;
         }
 
-        if (rtti.empty()) {
-                rtti.reserve(GameProcessInfo.rtti_map.size());
-                for (const auto& x : GameProcessInfo.rtti_map) {
-                        RTTIDetail d;
-                        d.name = x.first;
-                        d.offset = x.second.vtable_offset;
-                        d.vtable_ptr = 0;
-                        d.match = false;
-                        for (const auto i : d.name) {
-                                d.search_name += (char)::tolower(i);
-                        }
-                        rtti.push_back(d);
+        //a rescan can keep the class count, the list is rebuilt and filtered again whenever the names change
+        bool changed = false;
+        if (names_generation != rtti_names_generation()) {
+                names_generation = rtti_names_generation();
+                rtti.resize(rtti_names_count());
+                for (uint32_t i = 0; i < rtti.size(); ++i) {
+                        rtti[i] = RTTIDetail{ i, true };
                 }
+                result_count = rtti.size();
+                changed = true;
         }
 
-        static auto match_begin = rtti.begin();
-        static auto match_end = rtti.end();
+        if (ImGui::TreeNode("Version Migration")) {
+                draw_migration();
+                ImGui::TreePop();
+        }
 
-        if (ImGui::InputText("Search", searchbuffer, 128)) {
+        changed |= ImGui::InputText("Search", searchbuffer, 128);
+        changed |= ImGui::InputText("Namespace / template", tokenbuffer, sizeof(tokenbuffer));
+        if (changed) {
                 for (unsigned i = 0; searchbuffer[i]; ++i) {
                         searchbuffer[i] = (char)::tolower(searchbuffer[i]);
                 }
@@ -50,32 +186,49 @@ void draw_rtti_window() {
                 const char* error_string = NULL;
                 Reprog* regex = regcomp(searchbuffer, 0, &error_string);
 
+                //the token filter is a lookup in the token index, the search then only runs over its classes
+                std::vector<bool> in_token;
+                if (*tokenbuffer) {
+                        in_token.resize(rtti.size());
+                        const auto token = rtti_token_find(tokenbuffer);
+                        if (token != RTTI_TOKEN_NONE) {
+                                const uint32_t* ids;
+                                const auto count = rtti_token_classes(token, &ids);
+                                for (size_t i = 0; i < count; ++i) in_token[ids[i]] = true;
+                        }
+                }
+
                 for (auto& x : rtti) {
-                        if (*searchbuffer == '\0') {
+                        const auto lower = rtti_names_string(rtti_name(x.id).lower);
+                        if (!in_token.empty() && !in_token[x.id]) {
+                                x.match = false;
+                        }
+                        else if (*searchbuffer == '\0') {
                                 x.match = true;
                         }
                         else if (regex && (error_string == NULL)) {
                                 Resub result;
-                                regexec(regex, x.search_name.c_str(), &result, 0);
+                                regexec(regex, lower, &result, 0);
                                 x.match = (result.sub[0].sp != NULL);
                         }
                         else {
-                                x.match = (x.search_name.find(searchbuffer) != std::string::npos);
+                                x.match = (strstr(lower, searchbuffer) != NULL);
                         }
                 }
 
                 regfree(regex);
 
-                match_end = std::partition(
-                        match_begin,
+                //matches first, each group stays in name order
+                const auto match_end = std::stable_partition(
+                        rtti.begin(),
                         rtti.end(),
                         [](const RTTIDetail& x) noexcept -> bool {
                                 return x.match;
                         });
+                result_count = std::distance(rtti.begin(), match_end);
         }
 
-        auto result_count = std::distance(match_begin, match_end);
-        ImGui::Text("Results: %d / %d", result_count, rtti.size());
+        ImGui::Text("Results: %u / %u", (unsigned)result_count, (unsigned)rtti.size());
 
         ImGui::BeginChild("rtti_results_section", ImVec2{}, false, ImGuiWindowFlags_NoScrollbar);
 
@@ -84,11 +237,13 @@ void draw_rtti_window() {
         while (clip.Step()) {
                 for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
                         ImGui::PushID(i);
-                        auto& r = rtti[i];
-                        if (ImGui::CollapsingHeader(r.name.c_str())) {
+                        const auto& r = rtti_name(rtti[i].id);
+                        if (ImGui::CollapsingHeader(rtti_names_string(r.readable))) {
                                 static char vtable_text[64];
 
-                                const auto search = GameProcessInfo.rtti_map.find(r.name);
+                                const auto search = GameProcessInfo.rtti_map.find(r.mangled);
+
+                                ImGui::InputText("Mangled", (char*)r.mangled, strlen(r.mangled) + 1, ImGuiInputTextFlags_ReadOnly);
 
                                 snprintf(vtable_text, 64, "0x%p", (void*)(GameProcessInfo.base_address + search->second.vtable_offset));
                                 ImGui::InputText("Vtable Pointer", vtable_text, 64, ImGuiInputTextFlags_ReadOnly);
@@ -98,6 +253,17 @@ void draw_rtti_window() {
 
                                 snprintf(vtable_text, 64, "%u", search->second.func_count);
                                 ImGui::InputText("Member Count", vtable_text, 64, ImGuiInputTextFlags_ReadOnly);
+
+                                std::string tokens;
+                                const uint32_t* ids;
+                                const auto count = rtti_class_tokens(rtti[i].id, &ids);
+                                for (size_t k = 0; k < count; ++k) {
+                                        if (k) tokens += ", ";
+                                        tokens += rtti_token_string(ids[k]);
+                                }
+                                ImGui::Text("Tokens: %s", tokens.c_str());
+
+                                draw_hierarchy(r.mangled);
                         }
                         ImGui::PopID();
                 }
@@ -0,0 +1,404 @@
+#include "scan_kernels.h"
+
+#include <immintrin.h>
+#include <atomic>
+#include <mutex>
+
+//unsigned 64 bit compares below avx-512 are signed compares with the sign bit flipped
+static constexpr uint64_t SIGN_BIT = 0x8000000000000000ULL;
+
+
+static size_t find_qword_scalar(const uint64_t* data, size_t count, uint64_t needle) {
+	for (size_t i = 0; i < count; ++i) {
+		if (data[i] == needle) return i;
+	}
+	return count;
+}
+
+static size_t find_any_qword_scalar(const uint64_t* data, size_t count, const uint64_t* needles, unsigned needle_count) {
+	for (size_t i = 0; i < count; ++i) {
+		for (unsigned n = 0; n < needle_count; ++n) {
+			if (data[i] == needles[n]) return i;
+		}
+	}
+	return count;
+}
+
+static size_t find_qword_in_range_scalar(const uint64_t* data, size_t count, uint64_t lo, uint64_t hi) {
+	for (size_t i = 0; i < count; ++i) {
+		if ((data[i] >= lo) && (data[i] <= hi)) return i;
+	}
+	return count;
+}
+
+static size_t find_masked_byte_scalar(const uint8_t* data, size_t count, uint8_t value, uint8_t mask) {
+	for (size_t i = 0; i < count; ++i) {
+		if ((data[i] & mask) == value) return i;
+	}
+	return count;
+}
+
+
+static size_t find_qword_sse42(const uint64_t* data, size_t count, uint64_t needle) {
+	const __m128i n = _mm_set1_epi64x((long long)needle);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		const __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+		const unsigned m = (unsigned)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(x, n)));
+		if (m) return i + ((m & 1) ? 0 : 1);
+	}
+	return i + find_qword_scalar(data + i, count - i, needle);
+}
+
+static size_t find_any_qword_sse42(const uint64_t* data, size_t count, const uint64_t* needles, unsigned needle_count) {
+	__m128i n[SCAN_MAX_NEEDLES];
+	for (unsigned k = 0; k < needle_count; ++k) n[k] = _mm_set1_epi64x((long long)needles[k]);
+
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		const __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i eq = _mm_setzero_si128();
+		for (unsigned k = 0; k < needle_count; ++k) eq = _mm_or_si128(eq, _mm_cmpeq_epi64(x, n[k]));
+		const unsigned m = (unsigned)_mm_movemask_pd(_mm_castsi128_pd(eq));
+		if (m) return i + ((m & 1) ? 0 : 1);
+	}
+	return i + find_any_qword_scalar(data + i, count - i, needles, needle_count);
+}
+
+static size_t find_qword_in_range_sse42(const uint64_t* data, size_t count, uint64_t lo, uint64_t hi) {
+	const __m128i sign = _mm_set1_epi64x((long long)SIGN_BIT);
+	const __m128i l = _mm_set1_epi64x((long long)(lo ^ SIGN_BIT));
+	const __m128i h = _mm_set1_epi64x((long long)(hi ^ SIGN_BIT));
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		const __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + i)), sign);
+		const __m128i out = _mm_or_si128(_mm_cmpgt_epi64(l, x), _mm_cmpgt_epi64(x, h));
+		const unsigned m = ~(unsigned)_mm_movemask_pd(_mm_castsi128_pd(out)) & 0x3;
+		if (m) return i + ((m & 1) ? 0 : 1);
+	}
+	return i + find_qword_in_range_scalar(data + i, count - i, lo, hi);
+}
+
+static size_t find_masked_byte_sse42(const uint8_t* data, size_t count, uint8_t value, uint8_t mask) {
+	const __m128i v = _mm_set1_epi8((char)value);
+	const __m128i k = _mm_set1_epi8((char)mask);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+		const unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(x, k), v));
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_masked_byte_scalar(data + i, count - i, value, mask);
+}
+
+
+static size_t find_qword_avx2(const uint64_t* data, size_t count, uint64_t needle) {
+	const __m256i n = _mm256_set1_epi64x((long long)needle);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m256i x = _mm256_loadu_si256((const __m256i*)(data + i));
+		const unsigned m = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, n)));
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_qword_scalar(data + i, count - i, needle);
+}
+
+static size_t find_any_qword_avx2(const uint64_t* data, size_t count, const uint64_t* needles, unsigned needle_count) {
+	__m256i n[SCAN_MAX_NEEDLES];
+	for (unsigned k = 0; k < needle_count; ++k) n[k] = _mm256_set1_epi64x((long long)needles[k]);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m256i x = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i eq = _mm256_setzero_si256();
+		for (unsigned k = 0; k < needle_count; ++k) eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(x, n[k]));
+		const unsigned m = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(eq));
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_any_qword_scalar(data + i, count - i, needles, needle_count);
+}
+
+static size_t find_qword_in_range_avx2(const uint64_t* data, size_t count, uint64_t lo, uint64_t hi) {
+	const __m256i sign = _mm256_set1_epi64x((long long)SIGN_BIT);
+	const __m256i l = _mm256_set1_epi64x((long long)(lo ^ SIGN_BIT));
+	const __m256i h = _mm256_set1_epi64x((long long)(hi ^ SIGN_BIT));
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i)), sign);
+		const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(l, x), _mm256_cmpgt_epi64(x, h));
+		const unsigned m = ~(unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(out)) & 0xF;
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_qword_in_range_scalar(data + i, count - i, lo, hi);
+}
+
+static size_t find_masked_byte_avx2(const uint8_t* data, size_t count, uint8_t value, uint8_t mask) {
+	const __m256i v = _mm256_set1_epi8((char)value);
+	const __m256i k = _mm256_set1_epi8((char)mask);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		const __m256i x = _mm256_loadu_si256((const __m256i*)(data + i));
+		const unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(x, k), v));
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_masked_byte_scalar(data + i, count - i, value, mask);
+}
+
+
+static size_t find_qword_avx512(const uint64_t* data, size_t count, uint64_t needle) {
+	const __m512i n = _mm512_set1_epi64((long long)needle);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const unsigned m = _mm512_cmpeq_epu64_mask(_mm512_loadu_si512(data + i), n);
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_qword_scalar(data + i, count - i, needle);
+}
+
+static size_t find_any_qword_avx512(const uint64_t* data, size_t count, const uint64_t* needles, unsigned needle_count) {
+	__m512i n[SCAN_MAX_NEEDLES];
+	for (unsigned k = 0; k < needle_count; ++k) n[k] = _mm512_set1_epi64((long long)needles[k]);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m512i x = _mm512_loadu_si512(data + i);
+		unsigned m = 0;
+		for (unsigned k = 0; k < needle_count; ++k) m |= _mm512_cmpeq_epu64_mask(x, n[k]);
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_any_qword_scalar(data + i, count - i, needles, needle_count);
+}
+
+static size_t find_qword_in_range_avx512(const uint64_t* data, size_t count, uint64_t lo, uint64_t hi) {
+	const __m512i l = _mm512_set1_epi64((long long)lo);
+	const __m512i h = _mm512_set1_epi64((long long)hi);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m512i x = _mm512_loadu_si512(data + i);
+		const unsigned m = _mm512_cmp_epu64_mask(x, l, _MM_CMPINT_NLT) & _mm512_cmp_epu64_mask(x, h, _MM_CMPINT_LE);
+		if (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_qword_in_range_scalar(data + i, count - i, lo, hi);
+}
+
+static size_t find_masked_byte_avx512(const uint8_t* data, size_t count, uint8_t value, uint8_t mask) {
+	const __m512i v = _mm512_set1_epi8((char)value);
+	const __m512i k = _mm512_set1_epi8((char)mask);
+	size_t i = 0;
+	for (; i + 64 <= count; i += 64) {
+		const uint64_t m = _mm512_cmpeq_epi8_mask(_mm512_and_si512(_mm512_loadu_si512(data + i), k), v);
+		if (m) {
+			unsigned long bit;
+			_BitScanForward64(&bit, m);
+			return i + bit;
+		}
+	}
+	return i + find_masked_byte_scalar(data + i, count - i, value, mask);
+}
+
+
+static const ScanKernels Kernels[ScanKernel_Count] = {
+	{ "scalar", find_qword_scalar, find_any_qword_scalar, find_qword_in_range_scalar, find_masked_byte_scalar },
+	{ "sse42", find_qword_sse42, find_any_qword_sse42, find_qword_in_range_sse42, find_masked_byte_sse42 },
+	{ "avx2", find_qword_avx2, find_any_qword_avx2, find_qword_in_range_avx2, find_masked_byte_avx2 },
+	{ "avx512", find_qword_avx512, find_any_qword_avx512, find_qword_in_range_avx512, find_masked_byte_avx512 },
+};
+
+static ScanKernelLevel detect_level() {
+	int r[4];
+	__cpuid(r, 0);
+	const int max_leaf = r[0];
+
+	__cpuid(r, 1);
+	const bool sse42 = (r[2] & (1 << 19)) && (r[2] & (1 << 20));
+	const bool osxsave = (r[2] & (1 << 27)) && (r[2] & (1 << 28)); //and avx
+
+	//the os must save the ymm (bits 1-2) and zmm/opmask (bits 5-7) state on a context switch
+	const uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+	const bool os_avx = ((xcr0 & 0x6) == 0x6);
+	const bool os_avx512 = ((xcr0 & 0xE6) == 0xE6);
+
+	int ebx7 = 0;
+	if (max_leaf >= 7) {
+		__cpuidex(r, 7, 0);
+		ebx7 = r[1];
+	}
+	const bool avx2 = os_avx && (ebx7 & (1 << 5));
+	const bool avx512 = os_avx512 && (ebx7 & (1 << 16)) && (ebx7 & (1 << 30)); //F and BW
+
+	if (avx512 && avx2) return ScanKernel_AVX512;
+	if (avx2 && sse42) return ScanKernel_AVX2;
+	if (sse42) return ScanKernel_SSE42;
+	return ScanKernel_Scalar;
+}
+
+//batch workers can be the first users, so detection runs under call_once
+static struct {
+	std::once_flag init;
+	ScanKernelLevel detected;
+	std::atomic<unsigned> selected;
+} Dispatch{};
+
+static void init_dispatch() {
+	Dispatch.detected = detect_level();
+	Dispatch.selected = Dispatch.detected;
+	Log("Scan kernels: %s", Kernels[Dispatch.detected].name);
+}
+
+extern ScanKernelLevel scan_kernels_detect(void) {
+	std::call_once(Dispatch.init, init_dispatch);
+	return Dispatch.detected;
+}
+
+extern ScanKernelLevel scan_kernels_level(void) {
+	std::call_once(Dispatch.init, init_dispatch);
+	return (ScanKernelLevel)Dispatch.selected.load(std::memory_order_relaxed);
+}
+
+extern const ScanKernels& scan_kernels(void) {
+	return Kernels[scan_kernels_level()];
+}
+
+extern bool scan_kernels_force(ScanKernelLevel level) {
+	if ((level >= ScanKernel_Count) || (level > scan_kernels_detect())) {
+		Log("Scan kernels: %s is not supported by this cpu", (level < ScanKernel_Count) ? Kernels[level].name : "?");
+		return false;
+	}
+	Dispatch.selected = level;
+	Log("Scan kernels: %s (forced)", Kernels[level].name);
+	return true;
+}
+
+extern ScanKernelLevel scan_kernels_parse(const char* name) {
+	for (unsigned i = 0; i < ScanKernel_Count; ++i) {
+		if (!_stricmp(name, Kernels[i].name)) return (ScanKernelLevel)i;
+	}
+	return ScanKernel_Count;
+}
+
+
+//every length up to a few vectors and every start within a vector, with needles at the edges
+static bool check_kernels(const ScanKernels& k, const uint64_t* data, size_t size) {
+	const auto& ref = Kernels[ScanKernel_Scalar];
+	const auto bytes = (const uint8_t*)data;
+	constexpr uint64_t absent = 0x0123456789ABCDEFULL;
+
+	for (size_t start = 0; start < 8; ++start) {
+		for (size_t count = 0; count + start + 1 < size && count < 160; ++count) {
+			const auto d = data + start;
+			const uint64_t needles[SCAN_MAX_NEEDLES] = { absent, d[count], d[count / 2], d[count / 3], absent + 1, d[count / 4], absent + 2, d[0] };
+
+			for (unsigned n = 0; n < 3; ++n) {
+				if (k.find_qword(d, count, needles[n]) != ref.find_qword(d, count, needles[n])) return false;
+			}
+			for (unsigned n = 1; n <= SCAN_MAX_NEEDLES; ++n) {
+				if (k.find_any_qword(d, count, needles, n) != ref.find_any_qword(d, count, needles, n)) return false;
+			}
+
+			const uint64_t ranges[][2] = { { d[count], d[count] }, { d[count / 2], ~0ULL }, { 0, d[count / 2] }, { absent, absent + 2 }, { 0, ~0ULL } };
+			for (const auto& r : ranges) {
+				if (k.find_qword_in_range(d, count, r[0], r[1]) != ref.find_qword_in_range(d, count, r[0], r[1])) return false;
+			}
+
+			//byte searches use the same data with a finer start and longer lengths
+			const auto b = bytes + start * 9;
+			const auto blen = count * 3;
+			const uint8_t masks[] = { 0xFF, 0xF0, 0x0F, 0x80 };
+			for (const auto m : masks) {
+				const uint8_t values[] = { (uint8_t)(b[blen] & m), (uint8_t)(b[blen / 2] & m), (uint8_t)(0xA5 & m) };
+				for (const auto v : values) {
+					if (k.find_masked_byte(b, blen, v, m) != ref.find_masked_byte(b, blen, v, m)) return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static double gb_per_second(const LARGE_INTEGER& start, const LARGE_INTEGER& freq, size_t bytes) {
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	const auto seconds = (double)(now.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+	return seconds ? ((double)bytes / (1024.0 * 1024.0 * 1024.0) / seconds) : 0.0;
+}
+
+extern bool scan_kernels_self_test(void) {
+	constexpr size_t bench_count = 8 * 1024 * 1024; //64MB
+
+	//no byte has the top bit set, so the timed searches below never match and read the whole buffer
+	std::vector<uint64_t> data(bench_count);
+	uint64_t x = 0x9E3779B97F4A7C15ULL;
+	for (auto& d : data) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		d = x & 0x7F7F7F7F7F7F7F7FULL;
+	}
+
+	const auto detected = scan_kernels_detect();
+	const uint64_t needles[6] = { ~0ULL, ~1ULL, ~2ULL, ~3ULL, ~4ULL, ~5ULL };
+	bool ok = true;
+
+	LARGE_INTEGER freq, start;
+	QueryPerformanceFrequency(&freq);
+
+	for (unsigned level = 0; level <= detected; ++level) {
+		const auto& k = Kernels[level];
+		const auto passed = check_kernels(k, data.data(), 4096);
+		ok &= passed;
+
+		double rate[4];
+		size_t sink = 0;
+		QueryPerformanceCounter(&start);
+		sink += k.find_qword(data.data(), bench_count, ~0ULL);
+		rate[0] = gb_per_second(start, freq, bench_count * 8);
+
+		QueryPerformanceCounter(&start);
+		sink += k.find_any_qword(data.data(), bench_count, needles, 6);
+		rate[1] = gb_per_second(start, freq, bench_count * 8);
+
+		QueryPerformanceCounter(&start);
+		sink += k.find_qword_in_range(data.data(), bench_count, SIGN_BIT, ~0ULL);
+		rate[2] = gb_per_second(start, freq, bench_count * 8);
+
+		QueryPerformanceCounter(&start);
+		sink += k.find_masked_byte((const uint8_t*)data.data(), bench_count * 8, 0x80, 0x80);
+		rate[3] = gb_per_second(start, freq, bench_count * 8);
+
+		Log("%6s: %s, qword %5.2fGB/s, any of 6 %5.2fGB/s, range %5.2fGB/s, masked byte %5.2fGB/s (%zu)", k.name,
+			passed ? "ok" : "MISMATCH", rate[0], rate[1], rate[2], rate[3], sink);
+	}
+	return ok;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "main.h"
+
+//the inner loops shared by the image and heap scans, one variant per instruction set
+//the best variant the cpu and os support is picked with cpuid on first use
+
+enum ScanKernelLevel : unsigned {
+	ScanKernel_Scalar,
+	ScanKernel_SSE42,
+	ScanKernel_AVX2,
+	ScanKernel_AVX512, //F + BW
+	ScanKernel_Count,
+};
+
+constexpr unsigned SCAN_MAX_NEEDLES = 8; //find_any_qword
+
+//every kernel returns the index of the first match in [0, count) or count if there is none
+struct ScanKernels {
+	const char* name;
+
+	//data[i] == needle
+	size_t (*find_qword)(const uint64_t* data, size_t count, uint64_t needle);
+
+	//data[i] equals one of needle_count (<= SCAN_MAX_NEEDLES) needles
+	size_t (*find_any_qword)(const uint64_t* data, size_t count, const uint64_t* needles, unsigned needle_count);
+
+	//lo <= data[i] <= hi, unsigned
+	size_t (*find_qword_in_range)(const uint64_t* data, size_t count, uint64_t lo, uint64_t hi);
+
+	//(data[i] & mask) == value, the first byte of an aob signature
+	size_t (*find_masked_byte)(const uint8_t* data, size_t count, uint8_t value, uint8_t mask);
+};
+
+//the selected kernels
+extern const ScanKernels& scan_kernels(void);
+extern ScanKernelLevel scan_kernels_level(void);
+
+//the best level this cpu supports
+extern ScanKernelLevel scan_kernels_detect(void);
+
+//use a lower level, e.g. to compare variants, call before any scan starts
+//returns false if the cpu does not support the level
+extern bool scan_kernels_force(ScanKernelLevel level);
+
+//ScanKernel_Count if the name is not one of scalar, sse42, avx2, avx512
+extern ScanKernelLevel scan_kernels_parse(const char* name);
+
+//check every supported variant against the scalar one on random data and time them, results go to the log
+//returns false if any variant disagrees with the scalar kernels
+extern bool scan_kernels_self_test(void);
\ No newline at end of file
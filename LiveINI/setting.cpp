@@ -38,6 +38,48 @@ const char* Setting::GetGameSettingOriginName(const uint64_t gso) {
 	return "(error)";
 }
 
+bool Setting::ParseValue(const char* text, const uint64_t gst, GameValue* value) {
+	char* end = NULL;
+
+	while (::isspace((unsigned char)*text)) ++text;
+	if (!*text) return false;
+
+	if (gst & GameSettingFlag::TypeBool) {
+		if (!_stricmp(text, "true") || !strcmp(text, "1")) value->as_bool = 1;
+		else if (!_stricmp(text, "false") || !strcmp(text, "0")) value->as_bool = 0;
+		else return false;
+		return true;
+	}
+	if (gst & GameSettingFlag::TypeFloat) {
+		const float f = strtof(text, &end);
+		if (end == text) return false;
+		value->as_float = f;
+		return true;
+	}
+	if (gst & GameSettingFlag::TypeInt) {
+		const long i = strtol(text, &end, 0);
+		if (end == text) return false;
+		value->as_int = (int)i;
+		return true;
+	}
+	if (gst & GameSettingFlag::TypeUnsigned) {
+		const unsigned long u = strtoul(text, &end, 0);
+		if (end == text) return false;
+		value->as_unsigned = (unsigned)u;
+		return true;
+	}
+	if (gst & (GameSettingFlag::TypeRGB | GameSettingFlag::TypeRGBA)) {
+		unsigned r, g, b, a;
+		if (*text == '"') ++text;
+		if (sscanf_s(text, "%u,%u,%u,%u", &r, &g, &b, &a) != 4) return false;
+		if ((r | g | b | a) > 0xFF) return false;
+		value->as_unsigned = (r << 24) | (g << 16) | (b << 8) | a;
+		return true;
+	}
+
+	return false;
+}
+
 
 bool Setting::Update() {
 	GameSetting setting;
@@ -59,4 +101,78 @@ bool Setting::Update() {
 	this->m_active = this->m_current;
 	if (!WPM(this->m_address, &setting, sizeof(setting))) return false;
 	return true;
+}
+
+
+static constexpr uint32_t BATCH_MAX_RUN = 64 * 1024; //largest single RPM/WPM
+static constexpr uint32_t BATCH_MAX_GAP = 256;       //settings further apart than this are not coalesced
+
+SettingBatchStats Setting::UpdateBatch(SettingWrite* writes, size_t count) {
+	SettingBatchStats stats{};
+	std::vector<uint8_t> buffer(BATCH_MAX_RUN);
+
+	const auto in_run = [](const SettingWrite& first, const SettingWrite& prev, const SettingWrite& next) -> bool {
+		if ((next.address + sizeof(GameSetting)) - first.address > BATCH_MAX_RUN) return false;
+		return (next.address - (prev.address + sizeof(GameSetting))) <= BATCH_MAX_GAP;
+	};
+
+	size_t i = 0;
+	while (i < count) {
+		size_t end = i + 1;
+		while ((end < count) && in_run(writes[i], writes[end - 1], writes[end])) ++end;
+
+		const uintptr_t start = writes[i].address;
+		const auto run_size = (uint32_t)(writes[end - 1].address + sizeof(GameSetting) - start);
+
+		++stats.reads;
+		if (!RPM(start, buffer.data(), run_size)) {
+			for (size_t k = i; k < end; ++k) writes[k].status = SettingWrite_ReadFailed;
+			stats.failed += (uint32_t)(end - i);
+			i = end;
+			continue;
+		}
+
+		//guard checks against the local copy
+		for (size_t k = i; k < end; ++k) {
+			auto& w = writes[k];
+			GameSetting setting;
+			memcpy(&setting, &buffer[w.address - start], sizeof(setting));
+
+			if ((setting.vTable != w.expected.vTable) ||
+				(setting.Name != w.expected.Name) ||
+				(setting.Default.as_ptr != w.expected.Default.as_ptr)) {
+				w.status = SettingWrite_GuardFailed;
+				++stats.failed;
+				continue;
+			}
+
+			w.previous = setting.Active;
+			if (w.check_active && (setting.Active.as_ptr != w.expected.Active.as_ptr)) {
+				w.status = SettingWrite_ValueChanged;
+				++stats.failed;
+				continue;
+			}
+			w.status = (setting.Active.as_ptr == w.value.as_ptr) ? SettingWrite_Unchanged : SettingWrite_Written;
+		}
+
+		//only the active value of each setting that passed its guard is written, the bytes around it
+		//may have changed since the read and are left to the game
+		for (size_t k = i; k < end; ++k) {
+			auto& w = writes[k];
+			if (w.status != SettingWrite_Written) continue;
+
+			++stats.writes;
+			if (WPM(w.address + offsetof(GameSetting, Active), &w.value, sizeof(w.value))) {
+				++stats.written;
+			}
+			else {
+				w.status = SettingWrite_WriteFailed;
+				++stats.failed;
+			}
+		}
+
+		i = end;
+	}
+
+	return stats;
 }
\ No newline at end of file
@@ -38,10 +38,36 @@ enum GameSettingFlag : uint64_t {
 	OriginGameSetting	= 1 << 12,
 	OriginRegSetting	= 1 << 13,
 
-	FlagChanged = 1 << 13,
+	FlagChanged = 1 << 14,
 };
 
 
+//one entry of a guarded batch write, see Setting::UpdateBatch
+struct SettingWrite {
+	uintptr_t address;
+	GameSetting expected; //vtable, name and default must still match, exactly like Setting::Update
+	GameValue value;      //new active value
+	GameValue previous;   //active value read by the batch, valid unless the read or guard check failed
+	uint8_t status;       //SettingWriteStatus after the batch
+	bool check_active;    //the active value must also still be expected.Active, e.g. when undoing a write
+};
+
+enum SettingWriteStatus : uint8_t {
+	SettingWrite_Unchanged,   //active value already matched, nothing written
+	SettingWrite_Written,
+	SettingWrite_GuardFailed,
+	SettingWrite_ReadFailed,
+	SettingWrite_WriteFailed,
+	SettingWrite_ValueChanged, //check_active was set and the active value changed since, nothing written
+};
+
+struct SettingBatchStats {
+	uint32_t reads;   //RPM calls
+	uint32_t writes;  //WPM calls
+	uint32_t written; //settings whose active value was changed
+	uint32_t failed;  //settings that failed a guard check or could not be read/written
+};
+
 struct Setting {
 	uint64_t m_flags;
 	GameSetting m_setting;
@@ -56,5 +82,13 @@ struct Setting {
 	static const char* GetGameSettingTypeName(const uint64_t gst);
 	static const char* GetGameSettingOriginName(const uint64_t gso);
 
+	//parse text in the format written by the search results export into the typed part of value
+	//the remaining bytes of value are left as they are, string settings can not be parsed
+	static bool ParseValue(const char* text, const uint64_t gst, GameValue* value);
+
 	bool Update();
+
+	//apply many writes (sorted by address) reading them with as few RPM calls as possible
+	//nearby settings are read in one run, then only the active value of each changed setting is written
+	static SettingBatchStats UpdateBatch(SettingWrite* writes, size_t count);
 };
\ No newline at end of file
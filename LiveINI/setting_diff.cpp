@@ -0,0 +1,114 @@
+#include "setting_diff.h"
+#include "process.h"
+
+static constexpr uint32_t DIFF_MAX_STRING = 1024;
+
+//export names are nul terminated strings in a mapped file, hash them in place
+struct NameHash {
+	size_t operator()(const char* s) const {
+		uint64_t h = 14695981039346656037ULL;
+		for (; *s; ++s) h = (h ^ (uint8_t)*s) * 1099511628211ULL;
+		return (size_t)h;
+	}
+};
+
+struct NameEqual {
+	bool operator()(const char* a, const char* b) const {
+		return !strcmp(a, b);
+	}
+};
+
+static std::string format_current(const ExportView& previous, const Setting& s, const GameValue& value) {
+	if (s.m_flags & GameSettingFlag::TypeString) return ReadGameString(value.as_ptr, DIFF_MAX_STRING);
+	char str[64];
+	return export_format_value(previous, (uint8_t)(s.m_flags & 0xFF), value.as_ptr, str, sizeof(str));
+}
+
+extern void setting_diff(const ExportView& previous, const std::vector<Setting>& current, SettingDiff& diff) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	diff.rows.clear();
+	memset(diff.counts, 0, sizeof(diff.counts));
+	diff.unchanged = 0;
+
+	//rows with the same name are adjacent, the index points at the next one not matched yet
+	//so the n-th setting of a name in scan order pairs with the n-th export row of that name
+	const auto old_rows = previous.header->rows;
+	std::unordered_map<const char*, uint32_t, NameHash, NameEqual> index;
+	index.reserve(old_rows);
+	for (uint32_t i = 0; i < old_rows; ++i) {
+		index.emplace(previous.name(i), i);
+	}
+
+	std::vector<bool> matched(old_rows);
+
+	const auto add_row = [&](SettingDiffKind kind, uint32_t old_row, const Setting* s) {
+		SettingDiffRow row{};
+		row.kind = kind;
+		row.old_row = old_row;
+		if (s) {
+			row.name = s->m_name;
+			row.new_type = (uint8_t)(s->m_flags & 0xFF);
+			row.new_origin = (uint8_t)((s->m_flags >> 8) & 0x3F);
+			row.new_default = format_current(previous, *s, s->m_setting.Default);
+		}
+		else {
+			row.name = previous.name(old_row);
+		}
+		diff.rows.push_back(std::move(row));
+		++diff.counts[kind];
+	};
+
+	for (const auto& s : current) {
+		const auto found = index.find(s.m_name.c_str());
+		if ((found == index.end()) || (found->second == UINT32_MAX)) {
+			add_row(SettingDiff_Added, UINT32_MAX, &s);
+			continue;
+		}
+
+		const auto r = found->second;
+		matched[r] = true;
+		found->second = ((r + 1 < old_rows) && !strcmp(previous.name(r + 1), previous.name(r))) ? (r + 1) : UINT32_MAX;
+
+		const auto type = (uint8_t)(s.m_flags & 0xFF);
+		const auto origin = (uint8_t)((s.m_flags >> 8) & 0x3F);
+		if (previous.type[r] != type) {
+			add_row(SettingDiff_TypeChanged, r, &s);
+			continue;
+		}
+
+		bool same_default;
+		if (type & GameSettingFlag::TypeString) {
+			same_default = (ReadGameString(s.m_setting.Default.as_ptr, DIFF_MAX_STRING) == (previous.strings + previous.value_default[r]));
+		}
+		else {
+			same_default = (previous.value_default[r] == s.m_setting.Default.as_ptr);
+		}
+
+		if (!same_default) add_row(SettingDiff_DefaultChanged, r, &s);
+		else if (previous.origin[r] != origin) add_row(SettingDiff_OriginChanged, r, &s);
+		else ++diff.unchanged;
+	}
+
+	for (uint32_t i = 0; i < old_rows; ++i) {
+		if (!matched[i]) add_row(SettingDiff_Removed, i, NULL);
+	}
+
+	std::stable_sort(diff.rows.begin(), diff.rows.end(), [](const SettingDiffRow& a, const SettingDiffRow& b) { return a.name < b.name; });
+
+	QueryPerformanceCounter(&end);
+	diff.elapsed_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+}
+
+extern const char* setting_diff_kind_name(SettingDiffKind kind) {
+	switch (kind) {
+	case SettingDiff_Added: return "Added";
+	case SettingDiff_Removed: return "Removed";
+	case SettingDiff_DefaultChanged: return "Default Changed";
+	case SettingDiff_TypeChanged: return "Type Changed";
+	case SettingDiff_OriginChanged: return "Origin Changed";
+	default: return "(error)";
+	}
+}
\ No newline at end of file
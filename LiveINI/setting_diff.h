@@ -0,0 +1,36 @@
+#pragma once
+
+#include "setting_export.h"
+
+//compares a previous export against the settings of the current scan
+
+enum SettingDiffKind : uint8_t {
+	SettingDiff_Added,
+	SettingDiff_Removed,
+	SettingDiff_DefaultChanged,
+	SettingDiff_TypeChanged,
+	SettingDiff_OriginChanged,
+	SettingDiff_Count,
+};
+
+struct SettingDiffRow {
+	SettingDiffKind kind;
+	uint32_t old_row;        //row in the previous export, UINT32_MAX for added settings
+	uint8_t new_type;        //GameSettingFlag type bits of the current setting
+	uint8_t new_origin;      //GameSettingFlag origin bits >> 8 of the current setting
+	std::string name;
+	std::string new_default; //formatted default value of the current setting
+};
+
+struct SettingDiff {
+	std::vector<SettingDiffRow> rows; //sorted by name
+	uint32_t counts[SettingDiff_Count];
+	uint32_t unchanged;
+	double elapsed_ms;
+};
+
+/// join the previous export and the current settings on the setting name, settings sharing a name are paired by occurrence
+/// every setting is looked up once in a hash index of the export, export rows that were never matched are removed settings
+extern void setting_diff(const ExportView& previous, const std::vector<Setting>& current, SettingDiff& diff);
+
+extern const char* setting_diff_kind_name(SettingDiffKind kind);
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "setting_export.h"
+#include "process.h"
+
+static constexpr char EXPORT_MAGIC[8] = { 'L', 'I', 'N', 'I', 'E', 'X', 'P', 0 };
+
+static constexpr uint32_t EXPORT_MAX_STRING = 1024;
+
+static uint64_t align8(uint64_t x) {
+	return (x + 7) & ~7ULL;
+}
+
+extern std::vector<uint8_t> export_build(std::vector<Setting>::const_iterator begin, std::vector<Setting>::const_iterator end) {
+	std::vector<const Setting*> rows;
+	rows.reserve(std::distance(begin, end));
+	for (auto i = begin; i != end; ++i) {
+		rows.push_back(&*i);
+	}
+	//settings that share a name keep their scan order, diffs pair them up by occurrence
+	std::stable_sort(rows.begin(), rows.end(), [](const Setting* a, const Setting* b) { return strcmp(a->m_name.c_str(), b->m_name.c_str()) < 0; });
+
+	const auto count = (uint32_t)rows.size();
+	std::vector<uint32_t> name_offset(count);
+	std::vector<uint8_t> type(count);
+	std::vector<uint8_t> origin(count);
+	std::vector<uint64_t> modified((count + 63) / 64);
+	std::vector<uint64_t> value_default(count);
+	std::vector<uint64_t> value_ini(count);
+	std::vector<uint64_t> value_current(count);
+
+	std::string strings;
+	std::unordered_map<uintptr_t, uint32_t> remote_strings; //default and ini strings usually share a pointer
+
+	const auto add_string = [&](const char* str, size_t len) -> uint32_t {
+		const auto offset = (uint32_t)strings.size();
+		strings.append(str, len);
+		strings.push_back('\0');
+		return offset;
+	};
+	const auto add_remote_string = [&](uintptr_t address) -> uint32_t {
+		const auto found = remote_strings.find(address);
+		if (found != remote_strings.end()) return found->second;
+		const auto str = ReadGameString(address, EXPORT_MAX_STRING);
+		const auto offset = add_string(str.c_str(), str.size());
+		remote_strings.emplace(address, offset);
+		return offset;
+	};
+
+	for (uint32_t i = 0; i < count; ++i) {
+		const auto& s = *rows[i];
+		name_offset[i] = add_string(s.m_name.c_str(), s.m_name.size());
+		type[i] = (uint8_t)(s.m_flags & 0xFF);
+		origin[i] = (uint8_t)((s.m_flags >> 8) & 0x3F); //OriginUnknown to OriginRegSetting, FlagChanged is not exported
+
+		if (s.m_flags & GameSettingFlag::TypeString) {
+			value_default[i] = add_remote_string(s.m_setting.Default.as_ptr);
+			value_ini[i] = add_remote_string(s.m_setting.Active.as_ptr);
+			value_current[i] = add_remote_string(s.m_current.as_ptr);
+		}
+		else {
+			value_default[i] = s.m_setting.Default.as_ptr;
+			value_ini[i] = s.m_setting.Active.as_ptr;
+			value_current[i] = s.m_current.as_ptr;
+		}
+
+		if (value_current[i] != value_ini[i]) {
+			modified[i / 64] |= (1ULL << (i % 64));
+		}
+	}
+
+	ExportHeader hdr{};
+	memcpy(hdr.magic, EXPORT_MAGIC, sizeof(hdr.magic));
+	hdr.format = EXPORT_FORMAT_VERSION;
+	hdr.rows = count;
+	hdr.version = GameProcessInfo.exe.version;
+
+	const struct {
+		const void* data;
+		uint64_t size;
+	} columns[ExportColumn_Count] = {
+		{ name_offset.data(), count * sizeof(uint32_t) },
+		{ type.data(), count * sizeof(uint8_t) },
+		{ origin.data(), count * sizeof(uint8_t) },
+		{ modified.data(), modified.size() * sizeof(uint64_t) },
+		{ value_default.data(), count * sizeof(uint64_t) },
+		{ value_ini.data(), count * sizeof(uint64_t) },
+		{ value_current.data(), count * sizeof(uint64_t) },
+		{ strings.data(), strings.size() },
+	};
+
+	uint64_t offset = align8(sizeof(hdr));
+	for (unsigned c = 0; c < ExportColumn_Count; ++c) {
+		hdr.columns[c].offset = offset;
+		hdr.columns[c].size = columns[c].size;
+		offset = align8(offset + columns[c].size);
+	}
+
+	std::vector<uint8_t> out(offset);
+	memcpy(out.data(), &hdr, sizeof(hdr));
+	for (unsigned c = 0; c < ExportColumn_Count; ++c) {
+		if (columns[c].size) memcpy(out.data() + hdr.columns[c].offset, columns[c].data, (size_t)columns[c].size);
+	}
+	return out;
+}
+
+extern bool export_save(const char* path, const std::vector<uint8_t>& data) {
+	FILE* f = NULL;
+	fopen_s(&f, path, "wb");
+	if (!f) {
+		Log("Could not open %s for writing", path);
+		return false;
+	}
+	const auto written = fwrite(data.data(), 1, data.size(), f);
+	fclose(f);
+	return (written == data.size());
+}
+
+extern bool export_view(const void* data, uint64_t size, ExportView* view) {
+	*view = ExportView{};
+
+	const auto hdr = (const ExportHeader*)data;
+	if ((size < sizeof(*hdr)) || memcmp(hdr->magic, EXPORT_MAGIC, sizeof(hdr->magic))) {
+		Log("Not a LiveINI export");
+		return false;
+	}
+	if (hdr->format != EXPORT_FORMAT_VERSION) {
+		Log("Unsupported export format version %u", hdr->format);
+		return false;
+	}
+
+	const uint64_t rows = hdr->rows;
+	const uint64_t expected[ExportColumn_Count] = {
+		rows * sizeof(uint32_t),
+		rows,
+		rows,
+		((rows + 63) / 64) * sizeof(uint64_t),
+		rows * sizeof(uint64_t),
+		rows * sizeof(uint64_t),
+		rows * sizeof(uint64_t),
+		hdr->columns[ExportColumn_Strings].size,
+	};
+	for (unsigned c = 0; c < ExportColumn_Count; ++c) {
+		const auto& col = hdr->columns[c];
+		if ((col.size != expected[c]) || (col.offset & 7) || (col.offset > size) || (col.size > size - col.offset)) {
+			Log("Corrupt export column %u", c);
+			return false;
+		}
+	}
+
+	const auto base = (const uint8_t*)data;
+	view->header = hdr;
+	view->name_offset = (const uint32_t*)(base + hdr->columns[ExportColumn_NameOffset].offset);
+	view->type = base + hdr->columns[ExportColumn_Type].offset;
+	view->origin = base + hdr->columns[ExportColumn_Origin].offset;
+	view->modified = (const uint64_t*)(base + hdr->columns[ExportColumn_Modified].offset);
+	view->value_default = (const uint64_t*)(base + hdr->columns[ExportColumn_Default].offset);
+	view->value_ini = (const uint64_t*)(base + hdr->columns[ExportColumn_Ini].offset);
+	view->value_current = (const uint64_t*)(base + hdr->columns[ExportColumn_Current].offset);
+	view->strings = (const char*)(base + hdr->columns[ExportColumn_Strings].offset);
+	view->strings_size = hdr->columns[ExportColumn_Strings].size;
+
+	//every string offset must land inside the nul terminated string table
+	if (view->strings_size && view->strings[view->strings_size - 1]) {
+		Log("Corrupt export string table");
+		return false;
+	}
+	for (uint32_t i = 0; i < hdr->rows; ++i) {
+		bool ok = (view->name_offset[i] < view->strings_size);
+		if (view->type[i] & GameSettingFlag::TypeString) {
+			ok = ok && (view->value_default[i] < view->strings_size);
+			ok = ok && (view->value_ini[i] < view->strings_size);
+			ok = ok && (view->value_current[i] < view->strings_size);
+		}
+		if (!ok) {
+			Log("Corrupt export row %u", i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+extern bool export_open(const char* path, ExportView* view) {
+	*view = ExportView{};
+
+	const auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		Log("Could not open %s", path);
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || !size.QuadPart) {
+		Log("Could not get the size of %s", path);
+		CloseHandle(file);
+		return false;
+	}
+
+	const auto mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const auto data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!data) {
+		Log("Could not map %s", path);
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	if (!export_view(data, (uint64_t)size.QuadPart, view)) {
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	view->file = file;
+	view->mapping = mapping;
+	return true;
+}
+
+extern void export_close(ExportView* view) {
+	if (view->mapping) {
+		UnmapViewOfFile(view->header);
+		CloseHandle(view->mapping);
+		CloseHandle(view->file);
+	}
+	*view = ExportView{};
+}
+
+//same formatting as stringify_value in memory_scan.cpp
+extern const char* export_format_value(const ExportView& v, uint8_t type, uint64_t raw, char* str, size_t size) {
+	GameValue value;
+	value.as_ptr = (uintptr_t)raw;
+
+	if (type & GameSettingFlag::TypeBool) return (value.as_bool) ? "True" : "False";
+	if (type & GameSettingFlag::TypeFloat) snprintf(str, size, "%f", value.as_float);
+	else if (type & GameSettingFlag::TypeInt) snprintf(str, size, "%d", value.as_int);
+	else if (type & GameSettingFlag::TypeUnsigned) snprintf(str, size, "%u", value.as_unsigned);
+	else if (type & GameSettingFlag::TypeUnknown) return "<unknown>";
+	else if (type & GameSettingFlag::TypeString) return v.strings + raw;
+	else if (type & (GameSettingFlag::TypeRGB | GameSettingFlag::TypeRGBA)) {
+		const auto u = value.as_unsigned;
+		snprintf(str, size, "\"%u,%u,%u,%u\"", (u >> 24) & 0xFF, (u >> 16) & 0xFF, (u >> 8) & 0xFF, u & 0xFF);
+	}
+	else return "<error>";
+	return str;
+}
+
+static const char* origin_name(const ExportView& v, uint32_t row) {
+	return Setting::GetGameSettingOriginName((uint64_t)v.origin[row] << 8);
+}
+
+extern void export_write_text(const ExportView& view, FILE* f) {
+	fprintf(f, "## Generated by LiveINI - https://www.nexusmods.com/starfield/mods/976\r\n");
+	const auto& v = view.header->version;
+	fprintf(f, "## Starfield EXE version: %u.%u.%u.%u\r\n", v.major, v.minor, v.build, v.revision);
+	fprintf(f, "## Double pipe characters are used as the unique delimiter\r\n");
+	fprintf(f, "## Setting || DefaultValue || INIValue || CurrentValue || Origin\r\n");
+
+	char sdefault[64], sini[64], scur[64];
+	for (uint32_t i = 0; i < view.header->rows; ++i) {
+		const auto t = view.type[i];
+		fprintf(f, "%s || %s || %s || %s || %s\r\n",
+			view.name(i),
+			export_format_value(view, t, view.value_default[i], sdefault, sizeof(sdefault)),
+			export_format_value(view, t, view.value_ini[i], sini, sizeof(sini)),
+			export_format_value(view, t, view.value_current[i], scur, sizeof(scur)),
+			origin_name(view, i));
+	}
+}
+
+static bool same_value(const ExportView& a, uint32_t ra, uint64_t va, const ExportView& b, uint64_t vb) {
+	if (a.type[ra] & GameSettingFlag::TypeString) return !strcmp(a.strings + va, b.strings + vb);
+	return (va == vb);
+}
+
+extern ExportDiffStats export_diff(const ExportView& older, const ExportView& newer, FILE* out) {
+	ExportDiffStats stats{};
+	const auto& vo = older.header->version;
+	const auto& vn = newer.header->version;
+	if (out) {
+		fprintf(out, "## LiveINI diff %u.%u.%u.%u -> %u.%u.%u.%u\r\n", vo.major, vo.minor, vo.build, vo.revision, vn.major, vn.minor, vn.build, vn.revision);
+	}
+
+	char s1[64], s2[64];
+	const auto na = older.header->rows;
+	const auto nb = newer.header->rows;
+	uint32_t a = 0, b = 0;
+	while ((a < na) || (b < nb)) {
+		const int cmp = (a == na) ? 1 : (b == nb) ? -1 : strcmp(older.name(a), newer.name(b));
+
+		if (cmp < 0) {
+			++stats.removed;
+			if (out) fprintf(out, "- %s\r\n", older.name(a));
+			++a;
+			continue;
+		}
+		if (cmp > 0) {
+			++stats.added;
+			if (out) fprintf(out, "+ %s || %s || %s\r\n", newer.name(b), export_format_value(newer, newer.type[b], newer.value_default[b], s1, sizeof(s1)), origin_name(newer, b));
+			++b;
+			continue;
+		}
+
+		//same setting in both, only properties that belong to the executable are compared
+		bool changed = false;
+		if (older.type[a] != newer.type[b]) {
+			changed = true;
+			if (out) fprintf(out, "~ %s || type: %s -> %s\r\n", older.name(a), Setting::GetGameSettingTypeName(older.type[a]), Setting::GetGameSettingTypeName(newer.type[b]));
+		}
+		else if (!same_value(older, a, older.value_default[a], newer, newer.value_default[b])) {
+			changed = true;
+			if (out) {
+				fprintf(out, "~ %s || default: %s -> %s\r\n", older.name(a),
+					export_format_value(older, older.type[a], older.value_default[a], s1, sizeof(s1)),
+					export_format_value(newer, newer.type[b], newer.value_default[b], s2, sizeof(s2)));
+			}
+		}
+		if (older.origin[a] != newer.origin[b]) {
+			changed = true;
+			if (out) fprintf(out, "~ %s || origin: %s -> %s\r\n", older.name(a), origin_name(older, a), origin_name(newer, b));
+		}
+
+		if (changed) ++stats.changed;
+		else ++stats.unchanged;
+		++a;
+		++b;
+	}
+
+	return stats;
+}
\ No newline at end of file
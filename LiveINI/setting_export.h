@@ -0,0 +1,82 @@
+#pragma once
+
+#include "setting.h"
+
+//binary columnar export of the scanned settings
+//rows are sorted by name so two exports can be diffed with a single merge pass
+//the text export (search_results.txt) is rendered from this format
+
+constexpr uint32_t EXPORT_FORMAT_VERSION = 1;
+
+enum ExportColumn : unsigned {
+	ExportColumn_NameOffset,   //uint32_t per row, offset into the string table
+	ExportColumn_Type,         //uint8_t per row, GameSettingFlag type bits
+	ExportColumn_Origin,       //uint8_t per row, GameSettingFlag origin bits >> 8
+	ExportColumn_Modified,     //bitset, current value differs from the ini value
+	ExportColumn_Default,      //uint64_t per row, raw value or string table offset for string settings
+	ExportColumn_Ini,
+	ExportColumn_Current,
+	ExportColumn_Strings,      //nul terminated strings
+	ExportColumn_Count,
+};
+
+struct ExportHeader {
+	char magic[8];
+	uint32_t format;
+	uint32_t rows;
+	ProcessInfo::ExeInfo::VersionInfo version;
+	struct {
+		uint64_t offset;
+		uint64_t size;
+	} columns[ExportColumn_Count];
+};
+
+//read-only view of an export, either mapped from a file or over a memory buffer
+struct ExportView {
+	const ExportHeader* header;
+	const uint32_t* name_offset;
+	const uint8_t* type;
+	const uint8_t* origin;
+	const uint64_t* modified;
+	const uint64_t* value_default;
+	const uint64_t* value_ini;
+	const uint64_t* value_current;
+	const char* strings;
+	uint64_t strings_size;
+
+	HANDLE file;
+	HANDLE mapping;
+
+	const char* name(uint32_t row) const { return strings + name_offset[row]; }
+	bool is_modified(uint32_t row) const { return !!(modified[row / 64] & (1ULL << (row % 64))); }
+};
+
+struct ExportDiffStats {
+	uint32_t added;
+	uint32_t removed;
+	uint32_t changed;
+	uint32_t unchanged;
+};
+
+//build an export of the given settings, string values are read from the game
+extern std::vector<uint8_t> export_build(std::vector<Setting>::const_iterator begin, std::vector<Setting>::const_iterator end);
+
+//write the whole export with a single write
+extern bool export_save(const char* path, const std::vector<uint8_t>& data);
+
+//validate data and fill view, data must outlive the view
+extern bool export_view(const void* data, uint64_t size, ExportView* view);
+
+//map an export file read-only, release with export_close
+extern bool export_open(const char* path, ExportView* view);
+extern void export_close(ExportView* view);
+
+//format a value of the given row type, string values are looked up in the string table of view
+extern const char* export_format_value(const ExportView& view, uint8_t type, uint64_t raw, char* str, size_t size);
+
+//render the export in the search_results.txt format
+extern void export_write_text(const ExportView& view, FILE* f);
+
+/// compare two exports by setting name in one merge pass
+/// added, removed and changed rows are written to out if it is not null
+extern ExportDiffStats export_diff(const ExportView& older, const ExportView& newer, FILE* out);
\ No newline at end of file
@@ -0,0 +1,600 @@
+#include "snapshot.h"
+#include "process.h"
+
+#include <emmintrin.h>
+#include <memory>
+
+
+static constexpr uint32_t ZERO_PAGE = 0xFFFFFFFF;
+static constexpr uint32_t STORE_CHUNK_SIZE = 16 * 1024 * 1024;
+static constexpr uint32_t CAPTURE_READ_SIZE = 1024 * 1024;
+
+
+//lz4 block format restricted to a single page, so positions and offsets always fit in 16 bits
+//the encoder gives up (returns 0) if the page does not shrink by at least 1/16th
+static constexpr uint32_t LZ_MIN_MATCH = 4;
+static constexpr unsigned LZ_HASH_BITS = 12;
+
+static inline uint32_t read32(const uint8_t* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint8_t* write_length(uint8_t* op, uint32_t len) {
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+static uint32_t page_compress(const uint8_t* src, uint8_t* dst) {
+	uint16_t table[1 << LZ_HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	const uint32_t n = SNAPSHOT_PAGE_SIZE;
+	const uint32_t match_limit = n - 12; //the tail of the page is always emitted as literals
+	const uint32_t out_limit = n - (n / 16);
+	uint8_t* op = dst;
+	uint32_t ip = 1; //table entries are initialized to 0 so position 0 can never be a match candidate
+	uint32_t anchor = 0;
+	uint32_t misses = 0;
+
+	while (ip < match_limit) {
+		const uint32_t seq = read32(src + ip);
+		const uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+		const uint32_t ref = table[h];
+		table[h] = (uint16_t)ip;
+
+		if (!ref || (read32(src + ref) != seq)) {
+			ip += 1 + (misses++ >> 5); //skip faster through incompressible data
+			continue;
+		}
+		misses = 0;
+
+		uint32_t len = LZ_MIN_MATCH;
+		while ((ip + len < n - 5) && (src[ref + len] == src[ip + len])) ++len;
+
+		const uint32_t lit = ip - anchor;
+		//worst case size of this sequence
+		if ((uint32_t)(op - dst) + 1 + (lit / 255) + 1 + lit + 2 + (len / 255) + 1 > out_limit) return 0;
+
+		uint8_t* token = op++;
+		*token = (uint8_t)(((lit >= 15) ? 15 : lit) << 4);
+		if (lit >= 15) op = write_length(op, lit - 15);
+		memcpy(op, src + anchor, lit);
+		op += lit;
+
+		const uint32_t offset = ip - ref;
+		*op++ = (uint8_t)(offset & 0xFF);
+		*op++ = (uint8_t)(offset >> 8);
+
+		const uint32_t mlen = len - LZ_MIN_MATCH;
+		*token |= (uint8_t)((mlen >= 15) ? 15 : mlen);
+		if (mlen >= 15) op = write_length(op, mlen - 15);
+
+		ip += len;
+		anchor = ip;
+	}
+
+	const uint32_t lit = n - anchor;
+	if ((uint32_t)(op - dst) + 1 + (lit / 255) + 1 + lit > out_limit) return 0;
+	*op = (uint8_t)(((lit >= 15) ? 15 : lit) << 4);
+	++op;
+	if (lit >= 15) op = write_length(op, lit - 15);
+	memcpy(op, src + anchor, lit);
+	op += lit;
+
+	return (uint32_t)(op - dst);
+}
+
+static bool page_decompress(const uint8_t* src, uint32_t size, uint8_t* dst) {
+	const uint32_t n = SNAPSHOT_PAGE_SIZE;
+	uint32_t ip = 0;
+	uint32_t op = 0;
+
+	while (ip < size) {
+		const uint8_t token = src[ip++];
+
+		uint32_t lit = token >> 4;
+		if (lit == 15) {
+			uint8_t b;
+			do {
+				if (ip >= size) return false;
+				b = src[ip++];
+				lit += b;
+			} while (b == 255);
+		}
+		if ((ip + lit > size) || (op + lit > n)) return false;
+		memcpy(dst + op, src + ip, lit);
+		ip += lit;
+		op += lit;
+
+		if (ip == size) break; //the last sequence only has literals
+
+		if (ip + 2 > size) return false;
+		const uint32_t offset = src[ip] | (src[ip + 1] << 8);
+		ip += 2;
+
+		uint32_t len = token & 15;
+		if (len == 15) {
+			uint8_t b;
+			do {
+				if (ip >= size) return false;
+				b = src[ip++];
+				len += b;
+			} while (b == 255);
+		}
+		len += LZ_MIN_MATCH;
+
+		if ((offset == 0) || (offset > op) || (op + len > n)) return false;
+		const uint8_t* match = dst + op - offset;
+		if (offset >= len) {
+			memcpy(dst + op, match, len);
+		}
+		else {
+			for (uint32_t i = 0; i < len; ++i) dst[op + i] = match[i];
+		}
+		op += len;
+	}
+
+	return (op == n);
+}
+
+
+static bool page_is_zero(const uint8_t* page) {
+	__m128i acc = _mm_setzero_si128();
+	const __m128i* p = (const __m128i*)page;
+	for (uint32_t i = 0; i < SNAPSHOT_PAGE_SIZE / 16; i += 4) {
+		acc = _mm_or_si128(acc, _mm_or_si128(
+			_mm_or_si128(_mm_loadu_si128(p + i + 0), _mm_loadu_si128(p + i + 1)),
+			_mm_or_si128(_mm_loadu_si128(p + i + 2), _mm_loadu_si128(p + i + 3))));
+	}
+	return (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) == 0xFFFF);
+}
+
+//4 independent multiply lanes, 64 bits are used as the dedup key and 32 more bits verify a hit
+struct PageHash {
+	uint64_t key;
+	uint32_t check;
+};
+
+static PageHash page_hash(const uint8_t* page) {
+	constexpr uint64_t m = 0x9E3779B97F4A7C15ULL;
+	uint64_t h[4] = { 0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL };
+	for (uint32_t i = 0; i < SNAPSHOT_PAGE_SIZE; i += 32) {
+		for (unsigned l = 0; l < 4; ++l) {
+			uint64_t v;
+			memcpy(&v, page + i + (l * 8), sizeof(v));
+			h[l] = (h[l] ^ v) * m;
+			h[l] ^= h[l] >> 29;
+		}
+	}
+	PageHash ret;
+	ret.key = (h[0] ^ (h[1] >> 7)) + (h[2] ^ (h[3] << 11));
+	ret.key ^= ret.key >> 31;
+	ret.check = (uint32_t)((h[1] + h[3]) ^ ((h[0] + h[2]) >> 32));
+	return ret;
+}
+
+
+struct StoredPage {
+	uint32_t chunk;
+	uint32_t offset;
+	uint32_t check;
+	uint16_t size; //SNAPSHOT_PAGE_SIZE means stored uncompressed
+};
+
+//shared by every live snapshot, pages are never released individually
+//the whole store is dropped when the last snapshot is freed
+static struct {
+	std::vector<std::unique_ptr<uint8_t[]>> chunks;
+	uint32_t chunk_used;
+	std::vector<StoredPage> pages;
+	std::unordered_map<uint64_t, uint32_t> lookup;
+	uint64_t stored_bytes;
+	uint64_t snapshot_count;
+
+	//decompressed pages are cached per slot since comparisons touch the same page pair repeatedly
+	//ids are reused after a reset, so the cache is reset with the store
+	uint32_t cache_id[2] = { ZERO_PAGE, ZERO_PAGE };
+	alignas(16) uint8_t cache[2][SNAPSHOT_PAGE_SIZE];
+} Store{};
+
+static void store_reset() {
+	Store.chunks.clear();
+	Store.chunk_used = 0;
+	Store.pages.clear();
+	Store.pages.shrink_to_fit();
+	Store.lookup.clear();
+	Store.stored_bytes = 0;
+	Store.cache_id[0] = Store.cache_id[1] = ZERO_PAGE;
+}
+
+static uint32_t store_add(const uint8_t* page, bool* is_new) {
+	const auto hash = page_hash(page);
+
+	const auto found = Store.lookup.find(hash.key);
+	if ((found != Store.lookup.end()) && (Store.pages[found->second].check == hash.check)) {
+		*is_new = false;
+		return found->second;
+	}
+
+	uint8_t compressed[SNAPSHOT_PAGE_SIZE];
+	uint32_t size = page_compress(page, compressed);
+	const uint8_t* data = compressed;
+	if (!size) {
+		size = SNAPSHOT_PAGE_SIZE;
+		data = page;
+	}
+
+	if (Store.chunks.empty() || (Store.chunk_used + size > STORE_CHUNK_SIZE)) {
+		Store.chunks.emplace_back(new uint8_t[STORE_CHUNK_SIZE]);
+		Store.chunk_used = 0;
+	}
+
+	StoredPage sp;
+	sp.chunk = (uint32_t)(Store.chunks.size() - 1);
+	sp.offset = Store.chunk_used;
+	sp.check = hash.check;
+	sp.size = (uint16_t)size;
+	memcpy(Store.chunks.back().get() + Store.chunk_used, data, size);
+	Store.chunk_used += size;
+	Store.stored_bytes += size;
+
+	const auto id = (uint32_t)Store.pages.size();
+	Store.pages.push_back(sp);
+
+	//on a true 64 bit collision the older page keeps the lookup slot, the new one is just not deduplicated
+	if (found == Store.lookup.end()) {
+		Store.lookup.emplace(hash.key, id);
+	}
+
+	*is_new = true;
+	return id;
+}
+
+static const uint8_t* store_get(uint32_t id, unsigned slot) {
+	alignas(16) static uint8_t zero[SNAPSHOT_PAGE_SIZE];
+
+	if (id == ZERO_PAGE) return zero;
+	auto cache = Store.cache[slot];
+	if (Store.cache_id[slot] == id) return cache;
+
+	const auto& sp = Store.pages[id];
+	const uint8_t* data = Store.chunks[sp.chunk].get() + sp.offset;
+	if (sp.size == SNAPSHOT_PAGE_SIZE) {
+		memcpy(cache, data, SNAPSHOT_PAGE_SIZE);
+	}
+	else if (!page_decompress(data, sp.size, cache)) {
+		assert(false);
+		memset(cache, 0, SNAPSHOT_PAGE_SIZE);
+	}
+	Store.cache_id[slot] = id;
+	return cache;
+}
+
+
+struct SnapshotPage {
+	uintptr_t address;
+	uint32_t id;
+};
+
+struct Snapshot {
+	std::vector<SnapshotPage> pages; //sorted by address
+	SnapshotStats stats;
+};
+
+
+extern Snapshot* snapshot_capture(const std::vector<MemoryBlock>& regions) {
+	static uint8_t* ReadBuffer = NULL;
+
+	if (!ReadBuffer) {
+		ReadBuffer = (uint8_t*)_aligned_malloc(CAPTURE_READ_SIZE, SNAPSHOT_PAGE_SIZE);
+		if (!ReadBuffer) {
+			Log("Could not allocate snapshot read buffer");
+			return NULL;
+		}
+	}
+
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	auto sorted = regions;
+	std::sort(sorted.begin(), sorted.end(), [](const MemoryBlock& a, const MemoryBlock& b) { return a.address < b.address; });
+
+	uint64_t total_pages = 0;
+	for (const auto& r : sorted) total_pages += r.size / SNAPSHOT_PAGE_SIZE;
+
+	auto snap = new Snapshot{};
+	snap->pages.reserve(total_pages);
+	++Store.snapshot_count;
+
+	for (const auto& r : sorted) {
+		const uintptr_t first = (r.address + SNAPSHOT_PAGE_SIZE - 1) & ~(uintptr_t)(SNAPSHOT_PAGE_SIZE - 1);
+		const uintptr_t last = (r.address + r.size) & ~(uintptr_t)(SNAPSHOT_PAGE_SIZE - 1);
+
+		for (uintptr_t address = first; address < last; address += CAPTURE_READ_SIZE) {
+			const auto read_size = (uint32_t)(((last - address) > CAPTURE_READ_SIZE) ? CAPTURE_READ_SIZE : (last - address));
+			const auto page_count = read_size / SNAPSHOT_PAGE_SIZE;
+
+			if (!RPM(address, ReadBuffer, read_size)) {
+				snap->stats.failed_pages += page_count;
+				continue;
+			}
+
+			for (uint32_t p = 0; p < page_count; ++p) {
+				const uint8_t* page = ReadBuffer + (p * SNAPSHOT_PAGE_SIZE);
+				SnapshotPage sp;
+				sp.address = address + (p * SNAPSHOT_PAGE_SIZE);
+
+				if (page_is_zero(page)) {
+					sp.id = ZERO_PAGE;
+					++snap->stats.zero_pages;
+				}
+				else {
+					bool is_new;
+					sp.id = store_add(page, &is_new);
+					if (is_new) ++snap->stats.new_pages;
+				}
+
+				snap->pages.push_back(sp);
+			}
+		}
+	}
+
+	snap->stats.pages = snap->pages.size();
+
+	QueryPerformanceCounter(&end);
+	snap->stats.capture_ms = (uint64_t)((end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart);
+
+	Log("Snapshot: %llu pages, %llu zero, %llu new, %llu failed in %llums",
+		snap->stats.pages, snap->stats.zero_pages, snap->stats.new_pages, snap->stats.failed_pages, snap->stats.capture_ms);
+
+	return snap;
+}
+
+extern void snapshot_free(Snapshot* snap) {
+	if (!snap) return;
+	delete snap;
+	assert(Store.snapshot_count > 0);
+	if (--Store.snapshot_count == 0) {
+		store_reset();
+	}
+}
+
+extern SnapshotStats snapshot_stats(const Snapshot* snap) {
+	return snap->stats;
+}
+
+extern SnapshotStoreStats snapshot_store_stats(void) {
+	SnapshotStoreStats ret;
+	ret.unique_pages = Store.pages.size();
+	ret.stored_bytes = Store.stored_bytes;
+	ret.snapshot_count = Store.snapshot_count;
+	return ret;
+}
+
+static const SnapshotPage* find_page(const Snapshot* snap, uintptr_t page_address) {
+	const auto found = std::lower_bound(
+		snap->pages.begin(),
+		snap->pages.end(),
+		page_address,
+		[](const SnapshotPage& p, uintptr_t a) { return p.address < a; });
+
+	if ((found == snap->pages.end()) || (found->address != page_address)) return NULL;
+	return &*found;
+}
+
+extern bool snapshot_read(const Snapshot* snap, uintptr_t address, void* out, uint32_t size) {
+	uint8_t* dst = (uint8_t*)out;
+
+	while (size) {
+		const uintptr_t page_address = address & ~(uintptr_t)(SNAPSHOT_PAGE_SIZE - 1);
+		const uint32_t page_offset = (uint32_t)(address - page_address);
+		const uint32_t count = ((SNAPSHOT_PAGE_SIZE - page_offset) < size) ? (SNAPSHOT_PAGE_SIZE - page_offset) : size;
+
+		const auto page = find_page(snap, page_address);
+		if (!page) return false;
+
+		memcpy(dst, store_get(page->id, 0) + page_offset, count);
+		dst += count;
+		address += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+extern uint32_t snapshot_type_size(SnapshotType type) {
+	switch (type) {
+	case SnapshotType_Int32: return sizeof(int32_t);
+	case SnapshotType_Float: return sizeof(float);
+	case SnapshotType_Int64: return sizeof(int64_t);
+	case SnapshotType_Double: return sizeof(double);
+	}
+	return 0;
+}
+
+
+//per type compare kernels, each returns one bit per lane of a 16 byte block
+//the compare mode is a template parameter so the switch disappears at compile time
+struct KernelInt32 {
+	typedef int32_t type;
+	template<SnapshotCompare C> static unsigned mask(const uint8_t* o, const uint8_t* n, SnapshotValue v) {
+		const __m128i a = _mm_loadu_si128((const __m128i*)o);
+		const __m128i b = _mm_loadu_si128((const __m128i*)n);
+		__m128i r;
+		switch (C) {
+		case SnapshotCompare_Changed: r = _mm_xor_si128(_mm_cmpeq_epi32(a, b), _mm_set1_epi32(-1)); break;
+		case SnapshotCompare_Unchanged: r = _mm_cmpeq_epi32(a, b); break;
+		case SnapshotCompare_Increased: r = _mm_cmpgt_epi32(b, a); break;
+		case SnapshotCompare_Decreased: r = _mm_cmpgt_epi32(a, b); break;
+		default: r = _mm_cmpeq_epi32(b, _mm_set1_epi32(v.as_int32)); break;
+		}
+		return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(r));
+	}
+};
+
+struct KernelFloat {
+	typedef float type;
+	template<SnapshotCompare C> static unsigned mask(const uint8_t* o, const uint8_t* n, SnapshotValue v) {
+		const __m128 a = _mm_loadu_ps((const float*)o);
+		const __m128 b = _mm_loadu_ps((const float*)n);
+		__m128 r;
+		switch (C) {
+		case SnapshotCompare_Changed: r = _mm_cmpneq_ps(a, b); break;
+		case SnapshotCompare_Unchanged: r = _mm_cmpeq_ps(a, b); break;
+		case SnapshotCompare_Increased: r = _mm_cmpgt_ps(b, a); break;
+		case SnapshotCompare_Decreased: r = _mm_cmplt_ps(b, a); break;
+		default: r = _mm_cmpeq_ps(b, _mm_set1_ps(v.as_float)); break;
+		}
+		return (unsigned)_mm_movemask_ps(r);
+	}
+};
+
+struct KernelDouble {
+	typedef double type;
+	template<SnapshotCompare C> static unsigned mask(const uint8_t* o, const uint8_t* n, SnapshotValue v) {
+		const __m128d a = _mm_loadu_pd((const double*)o);
+		const __m128d b = _mm_loadu_pd((const double*)n);
+		__m128d r;
+		switch (C) {
+		case SnapshotCompare_Changed: r = _mm_cmpneq_pd(a, b); break;
+		case SnapshotCompare_Unchanged: r = _mm_cmpeq_pd(a, b); break;
+		case SnapshotCompare_Increased: r = _mm_cmpgt_pd(b, a); break;
+		case SnapshotCompare_Decreased: r = _mm_cmplt_pd(b, a); break;
+		default: r = _mm_cmpeq_pd(b, _mm_set1_pd(v.as_double)); break;
+		}
+		return (unsigned)_mm_movemask_pd(r);
+	}
+};
+
+//sse2 has no 64 bit integer compares, two scalar lanes are still branch free
+struct KernelInt64 {
+	typedef int64_t type;
+	template<SnapshotCompare C> static unsigned mask(const uint8_t* o, const uint8_t* n, SnapshotValue v) {
+		int64_t a[2], b[2];
+		memcpy(a, o, sizeof(a));
+		memcpy(b, n, sizeof(b));
+		unsigned ret = 0;
+		for (unsigned i = 0; i < 2; ++i) {
+			bool r;
+			switch (C) {
+			case SnapshotCompare_Changed: r = (a[i] != b[i]); break;
+			case SnapshotCompare_Unchanged: r = (a[i] == b[i]); break;
+			case SnapshotCompare_Increased: r = (b[i] > a[i]); break;
+			case SnapshotCompare_Decreased: r = (b[i] < a[i]); break;
+			default: r = (b[i] == v.as_int64); break;
+			}
+			ret |= ((unsigned)r << i);
+		}
+		return ret;
+	}
+};
+
+typedef uint64_t(*PageKernel)(uintptr_t address, const uint8_t* older, const uint8_t* newer, SnapshotValue v, std::vector<uintptr_t>& results);
+
+template<typename K, SnapshotCompare C>
+static uint64_t compare_page(uintptr_t address, const uint8_t* older, const uint8_t* newer, SnapshotValue v, std::vector<uintptr_t>& results) {
+	uint64_t count = 0;
+	for (uint32_t i = 0; i < SNAPSHOT_PAGE_SIZE; i += 16) {
+		unsigned m = K::template mask<C>(older + i, newer + i, v);
+		while (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			m &= m - 1;
+			++count;
+			if (results.size() < SNAPSHOT_MAX_RESULTS) {
+				results.push_back(address + i + (bit * sizeof(typename K::type)));
+			}
+		}
+	}
+	return count;
+}
+
+//scalar path for narrowing an existing result list
+template<typename K, SnapshotCompare C>
+static bool compare_one(const uint8_t* older, const uint8_t* newer, SnapshotValue v) {
+	//widen to a full 16 byte block and only look at the first lane
+	uint8_t a[16] = {}, b[16] = {};
+	memcpy(a, older, sizeof(typename K::type));
+	memcpy(b, newer, sizeof(typename K::type));
+	return (K::template mask<C>(a, b, v) & 1);
+}
+
+#define KERNEL_ROW(FN, K) { FN<K, SnapshotCompare_Changed>, FN<K, SnapshotCompare_Unchanged>, FN<K, SnapshotCompare_Increased>, FN<K, SnapshotCompare_Decreased>, FN<K, SnapshotCompare_Equal> }
+static const PageKernel page_kernels[4][5] = {
+	KERNEL_ROW(compare_page, KernelInt32),
+	KERNEL_ROW(compare_page, KernelFloat),
+	KERNEL_ROW(compare_page, KernelInt64),
+	KERNEL_ROW(compare_page, KernelDouble),
+};
+
+typedef bool(*ValueKernel)(const uint8_t* older, const uint8_t* newer, SnapshotValue v);
+static const ValueKernel value_kernels[4][5] = {
+	KERNEL_ROW(compare_one, KernelInt32),
+	KERNEL_ROW(compare_one, KernelFloat),
+	KERNEL_ROW(compare_one, KernelInt64),
+	KERNEL_ROW(compare_one, KernelDouble),
+};
+#undef KERNEL_ROW
+
+
+extern uint64_t snapshot_compare(const Snapshot* older, const Snapshot* newer, SnapshotType type, SnapshotCompare cmp, SnapshotValue value, const std::vector<uintptr_t>* filter, std::vector<uintptr_t>& results) {
+	assert(older && newer);
+	results.clear();
+
+	const auto type_size = snapshot_type_size(type);
+	const auto page_kernel = page_kernels[type][cmp];
+	const auto value_kernel = value_kernels[type][cmp];
+	const bool needs_older = (cmp != SnapshotCompare_Equal);
+
+	uint64_t count = 0;
+	auto o = older->pages.begin();
+	const auto o_end = older->pages.end();
+	size_t f = 0;
+
+	for (const auto& np : newer->pages) {
+		while ((o != o_end) && (o->address < np.address)) ++o;
+		const bool have_older = ((o != o_end) && (o->address == np.address));
+		if (needs_older && !have_older) continue;
+
+		const uint32_t older_id = (have_older) ? o->id : np.id;
+		const uintptr_t page_end = np.address + SNAPSHOT_PAGE_SIZE;
+
+		if (filter) {
+			const auto& fl = *filter;
+			while ((f < fl.size()) && (fl[f] < np.address)) ++f;
+			if ((f == fl.size()) || (fl[f] >= page_end)) continue;
+
+			const uint8_t* a = store_get(older_id, 0);
+			const uint8_t* b = store_get(np.id, 1);
+			for (; (f < fl.size()) && (fl[f] < page_end); ++f) {
+				const auto offset = (uint32_t)(fl[f] - np.address);
+				if (offset + type_size > SNAPSHOT_PAGE_SIZE) continue;
+				if (!value_kernel(a + offset, b + offset, value)) continue;
+				++count;
+				if (results.size() < SNAPSHOT_MAX_RESULTS) results.push_back(fl[f]);
+			}
+			continue;
+		}
+
+		//identical page ids mean identical contents, no need to look at the bytes
+		if (needs_older && (older_id == np.id)) {
+			if (cmp != SnapshotCompare_Unchanged) continue;
+			for (uint32_t i = 0; i < SNAPSHOT_PAGE_SIZE; i += type_size) {
+				++count;
+				if (results.size() < SNAPSHOT_MAX_RESULTS) results.push_back(np.address + i);
+			}
+			continue;
+		}
+
+		count += page_kernel(np.address, store_get(older_id, 0), store_get(np.id, 1), value, results);
+	}
+
+	return count;
+}
\ No newline at end of file
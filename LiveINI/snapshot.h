@@ -0,0 +1,68 @@
+#pragma once
+
+#include "main.h"
+
+// a snapshot is a page granular copy of remote memory regions
+// pages are deduplicated by hash across all live snapshots, all-zero pages are not stored
+// and everything else is lz4-style compressed, so an unchanged heap costs almost nothing to capture twice
+
+constexpr uint32_t SNAPSHOT_PAGE_SIZE = 4096;
+constexpr uint32_t SNAPSHOT_MAX_RESULTS = 4 * 1024 * 1024;
+
+enum SnapshotType : unsigned {
+	SnapshotType_Int32,
+	SnapshotType_Float,
+	SnapshotType_Int64,
+	SnapshotType_Double,
+};
+
+enum SnapshotCompare : unsigned {
+	SnapshotCompare_Changed,
+	SnapshotCompare_Unchanged,
+	SnapshotCompare_Increased,
+	SnapshotCompare_Decreased,
+	SnapshotCompare_Equal,
+};
+
+union SnapshotValue {
+	int32_t as_int32;
+	float   as_float;
+	int64_t as_int64;
+	double  as_double;
+};
+
+struct SnapshotStats {
+	uint64_t pages;        //pages referenced by this snapshot
+	uint64_t zero_pages;   //pages elided because they were all zero
+	uint64_t new_pages;    //pages that were not already in the page store
+	uint64_t failed_pages; //pages that could not be read
+	uint64_t capture_ms;
+};
+
+struct SnapshotStoreStats {
+	uint64_t unique_pages;
+	uint64_t stored_bytes;   //compressed bytes held by the page store
+	uint64_t snapshot_count;
+};
+
+//treat as opaque
+struct Snapshot;
+
+//capture the given regions of the game process, returns null on error
+extern Snapshot* snapshot_capture(const std::vector<MemoryBlock>& regions);
+
+//release a snapshot, the page store is reset once no snapshot references it
+extern void snapshot_free(Snapshot* snap);
+
+extern SnapshotStats snapshot_stats(const Snapshot* snap);
+extern SnapshotStoreStats snapshot_store_stats(void);
+
+//copy bytes out of a snapshot, returns false if any byte was not captured
+extern bool snapshot_read(const Snapshot* snap, uintptr_t address, void* out, uint32_t size);
+
+/// compare every aligned value of the given type between two snapshots of the same memory
+/// if filter is not null only the (sorted) addresses in filter are considered
+/// up to SNAPSHOT_MAX_RESULTS matching addresses are stored in results, returns the total match count
+extern uint64_t snapshot_compare(const Snapshot* older, const Snapshot* newer, SnapshotType type, SnapshotCompare cmp, SnapshotValue value, const std::vector<uintptr_t>* filter, std::vector<uintptr_t>& results);
+
+extern uint32_t snapshot_type_size(SnapshotType type);
\ No newline at end of file
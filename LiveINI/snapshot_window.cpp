@@ -0,0 +1,179 @@
+#include "main.h"
+#include "snapshot_window.h"
+#include "snapshot.h"
+#include "process.h"
+
+static std::vector<Snapshot*> Snapshots{};
+static std::vector<uintptr_t> CompareResults{};
+static uint64_t CompareCount = 0;
+static int CompareOlder = -1;
+static int CompareNewer = -1;
+static SnapshotType CompareType = SnapshotType_Int32;
+
+static void free_snapshots() {
+        for (auto s : Snapshots) {
+                snapshot_free(s);
+        }
+        Snapshots.clear();
+        CompareResults.clear();
+        CompareCount = 0;
+}
+
+static void capture_snapshot(bool writable_only, uint64_t min_size) {
+        const auto regions = GetScanRegions(writable_only, min_size);
+
+        Log("Snapshot: capturing %u regions", (unsigned)regions.size());
+        const auto snap = snapshot_capture(regions);
+        if (snap) {
+                Snapshots.push_back(snap);
+        }
+}
+
+static void format_value(char* out, size_t out_size, const Snapshot* snap, uintptr_t address, SnapshotType type) {
+        SnapshotValue v{};
+        if (!snapshot_read(snap, address, &v, snapshot_type_size(type))) {
+                snprintf(out, out_size, "??");
+                return;
+        }
+
+        switch (type) {
+        case SnapshotType_Int32: snprintf(out, out_size, "%d", v.as_int32); break;
+        case SnapshotType_Float: snprintf(out, out_size, "%f", v.as_float); break;
+        case SnapshotType_Int64: snprintf(out, out_size, "%lld", v.as_int64); break;
+        case SnapshotType_Double: snprintf(out, out_size, "%f", v.as_double); break;
+        }
+}
+
+static SnapshotValue parse_value(const char* text, SnapshotType type) {
+        SnapshotValue v{};
+        switch (type) {
+        case SnapshotType_Int32: v.as_int32 = (int32_t)strtol(text, NULL, 0); break;
+        case SnapshotType_Float: v.as_float = strtof(text, NULL); break;
+        case SnapshotType_Int64: v.as_int64 = strtoll(text, NULL, 0); break;
+        case SnapshotType_Double: v.as_double = strtod(text, NULL); break;
+        }
+        return v;
+}
+
+extern void draw_snapshot_window() {
+        static bool writable_only = true;
+        static int min_region_kb = 64;
+        static int type = SnapshotType_Int32;
+        static int compare = SnapshotCompare_Changed;
+        static char value_text[64];
+        static bool narrow = false;
+
+        if (!GameProcessInfo.rtti_map.size()) {
+                ImGui::Text("Press Scan Starfield in the log window");
+                return;
+        }
+
+        ImGui::Checkbox("Writable regions only", &writable_only);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120.f);
+        ImGui::InputInt("Min region KB", &min_region_kb);
+        if (min_region_kb < 4) min_region_kb = 4;
+
+        if (ImGui::Button("Capture Snapshot")) {
+                capture_snapshot(writable_only, (uint64_t)min_region_kb * 1024);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Free Snapshots")) {
+                free_snapshots();
+        }
+
+        const auto store = snapshot_store_stats();
+        ImGui::Text("Page store: %llu unique pages, %lluMB stored (%lluMB raw)",
+                store.unique_pages, store.stored_bytes / (1024 * 1024), (store.unique_pages * SNAPSHOT_PAGE_SIZE) / (1024 * 1024));
+
+        for (size_t i = 0; i < Snapshots.size(); ++i) {
+                const auto s = snapshot_stats(Snapshots[i]);
+                ImGui::Text("#%u: %lluMB in %llu pages, %llu zero, %llu new, %llu unreadable, %llums",
+                        (unsigned)i, (s.pages * SNAPSHOT_PAGE_SIZE) / (1024 * 1024), s.pages, s.zero_pages, s.new_pages, s.failed_pages, s.capture_ms);
+        }
+
+        if (Snapshots.size() < 2) {
+                ImGui::Text("Capture two snapshots to compare them");
+                return;
+        }
+
+        ImGui::Separator();
+
+        static int older = 0;
+        static int newer = 1;
+        const int last = (int)Snapshots.size() - 1;
+        ImGui::SetNextItemWidth(120.f);
+        ImGui::SliderInt("Older", &older, 0, last);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120.f);
+        ImGui::SliderInt("Newer", &newer, 0, last);
+        older = (older < 0) ? 0 : (older > last) ? last : older;
+        newer = (newer < 0) ? 0 : (newer > last) ? last : newer;
+
+        ImGui::SetNextItemWidth(120.f);
+        ImGui::Combo("Type", &type, "Int32\0Float\0Int64\0Double\0");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120.f);
+        ImGui::Combo("Compare", &compare, "Changed\0Unchanged\0Increased\0Decreased\0Equal To\0");
+        if (compare == SnapshotCompare_Equal) {
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120.f);
+                ImGui::InputText("Value", value_text, sizeof(value_text));
+        }
+
+        ImGui::Checkbox("Narrow previous results", &narrow);
+        ImGui::SameLine();
+        if (ImGui::Button("Compare")) {
+                const auto t = (SnapshotType)type;
+                const bool use_filter = narrow && !CompareResults.empty() && (t == CompareType);
+                std::vector<uintptr_t> previous;
+                if (use_filter) {
+                        previous.swap(CompareResults);
+                }
+
+                LARGE_INTEGER freq, start, end;
+                QueryPerformanceFrequency(&freq);
+                QueryPerformanceCounter(&start);
+
+                CompareCount = snapshot_compare(
+                        Snapshots[older],
+                        Snapshots[newer],
+                        t,
+                        (SnapshotCompare)compare,
+                        parse_value(value_text, t),
+                        (use_filter) ? &previous : NULL,
+                        CompareResults);
+
+                QueryPerformanceCounter(&end);
+                Log("Snapshot compare: %llu matches in %llums", CompareCount, (uint64_t)((end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart));
+
+                CompareOlder = older;
+                CompareNewer = newer;
+                CompareType = t;
+        }
+
+        ImGui::Text("%llu matches (%u listed)", CompareCount, (unsigned)CompareResults.size());
+
+        if ((CompareOlder > last) || (CompareNewer > last)) {
+                return;
+        }
+
+        ImGui::BeginChild("snapshot_results");
+        ImGuiListClipper clip;
+        clip.Begin((int)CompareResults.size(), ImGui::GetTextLineHeightWithSpacing());
+        while (clip.Step()) {
+                for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
+                        char old_value[64];
+                        char new_value[64];
+                        char text[192];
+                        const auto address = CompareResults[i];
+                        format_value(old_value, sizeof(old_value), Snapshots[CompareOlder], address, CompareType);
+                        format_value(new_value, sizeof(new_value), Snapshots[CompareNewer], address, CompareType);
+                        snprintf(text, sizeof(text), "%p: %s -> %s", (void*)address, old_value, new_value);
+                        ImGui::PushID(i);
+                        ImGui::InputText("Address", text, sizeof(text), ImGuiInputTextFlags_ReadOnly);
+                        ImGui::PopID();
+                }
+        }
+        ImGui::EndChild();
+}
\ No newline at end of file
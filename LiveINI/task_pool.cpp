@@ -0,0 +1,258 @@
+#include "main.h"
+#include "task_pool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct Task {
+	std::function<void()> fn;
+	TaskGroup* group;
+	const TaskCancel* cancel;
+};
+
+struct WorkerQueue {
+	std::mutex lock;
+	std::deque<Task> tasks[TaskPriority_Count];
+};
+
+//queues are allocated for the most threads up front, so the pool can grow while workers look at them
+static constexpr unsigned POOL_MAX_THREADS = 64;
+
+static struct {
+	std::mutex lifecycle;
+	std::atomic<bool> running;
+	TaskPoolOptions options;
+	bool restrict_priority;
+	uint64_t restrict_affinity;
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<unsigned> started; //threads.size(), read by the workers without the lifecycle lock
+	std::atomic<unsigned> active;  //workers at or above this index are parked, they only finish their running task
+	std::atomic<unsigned> next_queue; //round robin for submits from outside the pool
+
+	//workers sleep on wake while nothing is queued, waiters on done while their group has tasks running elsewhere
+	std::mutex sleep_lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	std::atomic<size_t> queued;
+	bool stopping;
+} Pool{};
+
+//index of the queue owned by the current thread, -1 outside the pool
+static thread_local int WorkerIndex = -1;
+
+static void run_task(Task& t) {
+	if (!t.cancel || !t.cancel->cancelled()) t.fn();
+	t.fn = nullptr;
+
+	//nothing may touch the group after the decrement, the waiter can return and destroy it
+	if (t.group && (--t.group->pending == 0)) {
+		std::lock_guard<std::mutex> l(Pool.sleep_lock);
+		Pool.done.notify_all();
+	}
+}
+
+//own queue newest first (its data is still in cache), then the oldest task of another queue, highest priority first
+static bool take_task(int index, Task& out) {
+	const auto count = (size_t)Pool.started;
+	for (unsigned p = 0; p < TaskPriority_Count; ++p) {
+		if (index >= 0) {
+			auto& q = *Pool.queues[index];
+			std::lock_guard<std::mutex> l(q.lock);
+			if (!q.tasks[p].empty()) {
+				out = std::move(q.tasks[p].back());
+				q.tasks[p].pop_back();
+				--Pool.queued;
+				return true;
+			}
+		}
+		for (size_t k = 1; k <= count; ++k) {
+			const auto victim = (size_t)(index + k) % count;
+			if ((int)victim == index) continue;
+			auto& q = *Pool.queues[victim];
+			std::lock_guard<std::mutex> l(q.lock);
+			if (!q.tasks[p].empty()) {
+				out = std::move(q.tasks[p].front());
+				q.tasks[p].pop_front();
+				--Pool.queued;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+//a waiter only runs tasks of its own group, an unrelated long task could otherwise stall it
+static bool take_group_task(const TaskGroup& group, Task& out) {
+	const auto count = Pool.started.load();
+	for (unsigned i = 0; i < count; ++i) {
+		auto& q = *Pool.queues[i];
+		std::lock_guard<std::mutex> l(q.lock);
+		for (unsigned p = 0; p < TaskPriority_Count; ++p) {
+			for (auto it = q.tasks[p].begin(); it != q.tasks[p].end(); ++it) {
+				if (it->group != &group) continue;
+				out = std::move(*it);
+				q.tasks[p].erase(it);
+				--Pool.queued;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static void worker_thread(int index) {
+	WorkerIndex = index;
+	for (;;) {
+		Task t;
+		if (((unsigned)index < Pool.active) && take_task(index, t)) {
+			run_task(t);
+			continue;
+		}
+
+		//tasks left in a parked worker's queue are stolen by the active ones
+		std::unique_lock<std::mutex> l(Pool.sleep_lock);
+		Pool.wake.wait(l, [index] { return Pool.stopping || (((unsigned)index < Pool.active) && Pool.queued); });
+		if (Pool.stopping && (!Pool.queued || ((unsigned)index >= Pool.active))) return;
+	}
+}
+
+static unsigned option_threads(const TaskPoolOptions& options) {
+	unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+	if (!threads) threads = 4;
+	return (threads < POOL_MAX_THREADS) ? threads : POOL_MAX_THREADS;
+}
+
+static void apply_thread_options(std::thread& t) {
+	const auto handle = (HANDLE)t.native_handle();
+	SetThreadPriority(handle, Pool.restrict_priority ? THREAD_PRIORITY_LOWEST : THREAD_PRIORITY_BELOW_NORMAL);
+
+	//an empty mask goes back to every core the process may use
+	DWORD_PTR mask = (DWORD_PTR)(Pool.restrict_affinity ? Pool.restrict_affinity : Pool.options.affinity), system;
+	if (!mask) GetProcessAffinityMask(GetCurrentProcess(), &mask, &system);
+	SetThreadAffinityMask(handle, mask);
+}
+
+//lifecycle lock held, starts the missing workers and parks or wakes the rest, nothing is joined
+static void apply_options() {
+	const auto threads = option_threads(Pool.options);
+	for (unsigned i = (unsigned)Pool.threads.size(); i < threads; ++i) {
+		Pool.threads.emplace_back(worker_thread, (int)i);
+		++Pool.started;
+	}
+	for (auto& t : Pool.threads) apply_thread_options(t);
+
+	{
+		std::lock_guard<std::mutex> l(Pool.sleep_lock);
+		Pool.active = threads;
+	}
+	Pool.wake.notify_all();
+
+	if (Pool.options.affinity) Log("Task pool: %u threads on cores %llX", threads, Pool.options.affinity);
+	else Log("Task pool: %u threads", threads);
+}
+
+static void start_pool() {
+	Pool.stopping = false;
+	Pool.queued = 0;
+	Pool.started = 0;
+	Pool.active = 0;
+	Pool.queues.clear();
+	for (unsigned i = 0; i < POOL_MAX_THREADS; ++i) Pool.queues.emplace_back(new WorkerQueue);
+
+	apply_options();
+	Pool.running = true;
+
+	//the workers must be joined before the statics they wait on are destroyed
+	static bool registered = false;
+	if (!registered) atexit(task_pool_shutdown);
+	registered = true;
+}
+
+static void ensure_started() {
+	if (Pool.running) return;
+	std::lock_guard<std::mutex> l(Pool.lifecycle);
+	if (!Pool.running) start_pool();
+}
+
+extern void task_pool_shutdown(void) {
+	std::lock_guard<std::mutex> l(Pool.lifecycle);
+	if (!Pool.running) return;
+
+	{
+		std::lock_guard<std::mutex> s(Pool.sleep_lock);
+		Pool.stopping = true;
+	}
+	Pool.wake.notify_all();
+	for (auto& t : Pool.threads) t.join();
+	Pool.threads.clear();
+	Pool.started = 0;
+	Pool.active = 0;
+	Pool.queues.clear();
+	Pool.running = false;
+}
+
+extern void task_pool_configure(const TaskPoolOptions& options) {
+	std::lock_guard<std::mutex> l(Pool.lifecycle);
+	Pool.options = options;
+	if (Pool.running) apply_options();
+}
+
+extern void task_pool_restrict(bool lowest_priority, uint64_t affinity) {
+	std::lock_guard<std::mutex> l(Pool.lifecycle);
+	Pool.restrict_priority = lowest_priority;
+	Pool.restrict_affinity = affinity;
+	for (auto& t : Pool.threads) apply_thread_options(t);
+}
+
+extern TaskPoolOptions task_pool_options(void) {
+	std::lock_guard<std::mutex> l(Pool.lifecycle);
+	return Pool.options;
+}
+
+extern unsigned task_pool_threads(void) {
+	ensure_started();
+	return Pool.active;
+}
+
+extern size_t parallel_grain(size_t count, size_t min_grain) {
+	const size_t chunks = (size_t)task_pool_threads() * 4;
+	const size_t grain = (count + chunks - 1) / chunks;
+	return (grain > min_grain) ? grain : min_grain;
+}
+
+extern void task_submit(std::function<void()> fn, TaskGroup* group, TaskPriority priority, const TaskCancel* cancel) {
+	ensure_started();
+	if (group) ++group->pending;
+
+	const auto index = (WorkerIndex >= 0) ? (unsigned)WorkerIndex : (Pool.next_queue++ % Pool.active);
+	auto& q = *Pool.queues[index];
+	{
+		std::lock_guard<std::mutex> l(q.lock);
+		q.tasks[priority].push_back(Task{ std::move(fn), group, cancel });
+		++Pool.queued;
+	}
+
+	//a worker checks queued under sleep_lock, taking it here means the worker is either waiting or sees the task
+	{
+		std::lock_guard<std::mutex> l(Pool.sleep_lock);
+	}
+	Pool.wake.notify_one();
+}
+
+extern void task_wait(TaskGroup& group) {
+	while (group.pending) {
+		Task t;
+		if (take_group_task(group, t)) {
+			run_task(t);
+			continue;
+		}
+
+		//the rest of the group is running on other threads, a task it submits is picked up after at most 1ms
+		std::unique_lock<std::mutex> l(Pool.sleep_lock);
+		Pool.done.wait_for(l, std::chrono::milliseconds(1), [&] { return !group.pending; });
+	}
+}
\ No newline at end of file
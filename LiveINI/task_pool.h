@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+//one pool of worker threads shared by every analysis and scan, so they never add up to more threads than configured
+//each worker has its own queue and steals from the others when it runs dry
+//workers run below normal priority and can be pinned to a set of cores, leaving the rest to the game
+
+enum TaskPriority : unsigned {
+	TaskPriority_High,       //the ui is waiting for it
+	TaskPriority_Normal,
+	TaskPriority_Background, //e.g. the text index build, runs when nothing else is queued
+	TaskPriority_Count,
+};
+
+//tasks that have not started when cancel() is called are skipped, running tasks can poll cancelled()
+struct TaskCancel {
+	std::atomic<bool> flag{ false };
+	void cancel() { flag = true; }
+	void reset() { flag = false; }
+	bool cancelled() const { return flag.load(std::memory_order_relaxed); }
+};
+
+//counts the unfinished tasks submitted with it
+struct TaskGroup {
+	std::atomic<size_t> pending{ 0 };
+};
+
+struct TaskPoolOptions {
+	unsigned threads; //0 for one per core
+	uint64_t affinity; //cores the workers may run on, 0 for all
+};
+
+//applied to the running workers without waiting for their tasks, extra workers are started
+//and surplus ones parked once their current task returns
+extern void task_pool_configure(const TaskPoolOptions& options);
+extern TaskPoolOptions task_pool_options(void);
+extern unsigned task_pool_threads(void);
+
+//gentle mode's hold on the running workers, kept apart from the options so neither overwrites the other
+//lowest_priority uses THREAD_PRIORITY_LOWEST instead of BELOW_NORMAL, a nonzero affinity overrides the options' one
+extern void task_pool_restrict(bool lowest_priority, uint64_t affinity);
+
+//finish the queued tasks and join the workers, the pool restarts on the next submit
+//runs at exit as well
+extern void task_pool_shutdown(void);
+
+extern void task_submit(std::function<void()> fn, TaskGroup* group, TaskPriority priority = TaskPriority_Normal, const TaskCancel* cancel = NULL);
+
+//wait for every task of the group, the calling thread runs queued tasks of the group meanwhile
+//so waiting inside a task can not deadlock the pool
+extern void task_wait(TaskGroup& group);
+
+//run fn(begin, end) over [0, count) in chunks of grain items and wait for all of them
+//chunk k covers [k * grain, min((k + 1) * grain, count)), so per chunk results can be stored at begin / grain
+template<typename Fn>
+static void parallel_for(size_t count, size_t grain, Fn fn, TaskPriority priority = TaskPriority_Normal, const TaskCancel* cancel = NULL) {
+	if (!count) return;
+	if (!grain) grain = 1;
+	if (count <= grain) {
+		if (!cancel || !cancel->cancelled()) fn((size_t)0, count);
+		return;
+	}
+
+	TaskGroup group;
+	for (size_t begin = 0; begin < count; begin += grain) {
+		const size_t end = (begin + grain < count) ? begin + grain : count;
+		task_submit([&fn, begin, end] { fn(begin, end); }, &group, priority, cancel);
+	}
+	task_wait(group);
+}
+
+//chunks of about count / (4 * threads) items, at least min_grain
+extern size_t parallel_grain(size_t count, size_t min_grain);
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "text_index.h"
+#include "task_pool.h"
+
+static constexpr char INDEX_MAGIC[8] = { 'L', 'I', 'N', 'I', 'S', 'A', 0, 0 };
+static constexpr uint32_t INDEX_FORMAT = 1;
+
+struct IndexFileHeader {
+	char magic[8];
+	uint32_t format;
+	uint32_t text_size;
+	uint64_t text_hash;
+	ProcessInfo::ExeInfo::VersionInfo version;
+};
+
+static struct {
+	TaskGroup worker;
+	std::atomic<unsigned> state;
+	TaskCancel cancel;
+
+	std::vector<uint8_t> text;  //copy of .text
+	std::vector<int32_t> sa;
+	uint32_t text_offset;       //rva of .text
+	bool from_cache;
+	double build_ms;
+} Index{};
+
+
+//sa-is (nong, zhang & chan), linear time and about 9 bytes per input byte at the top level
+//s has values in [0, upper], there is no sentinel
+template<typename T>
+static std::vector<int32_t> sa_is(const T* s, int32_t n, int32_t upper) {
+	std::vector<int32_t> sa(n);
+	if (Index.cancel.cancelled()) return sa;
+	if (n == 0) return sa;
+	if (n == 1) {
+		sa[0] = 0;
+		return sa;
+	}
+	if (n < 16) {
+		for (int32_t i = 0; i < n; ++i) sa[i] = i;
+		//distinct suffixes never compare equal (one is a prefix of the other at most), a suffix against itself must be false
+		std::sort(sa.begin(), sa.end(), [&](int32_t a, int32_t b) {
+			if (a == b) return false;
+			while ((a < n) && (b < n) && (s[a] == s[b])) ++a, ++b;
+			if (a == n) return true;
+			if (b == n) return false;
+			return s[a] < s[b];
+		});
+		return sa;
+	}
+
+	//ls[i]: suffix i is s-type (smaller than suffix i + 1)
+	std::vector<bool> ls(n);
+	for (int32_t i = n - 2; i >= 0; --i) {
+		ls[i] = (s[i] == s[i + 1]) ? ls[i + 1] : (s[i] < s[i + 1]);
+	}
+
+	std::vector<int32_t> sum_l(upper + 1), sum_s(upper + 1);
+	for (int32_t i = 0; i < n; ++i) {
+		if (!ls[i]) ++sum_s[s[i]];
+		else ++sum_l[s[i] + 1];
+	}
+	for (int32_t i = 0; i <= upper; ++i) {
+		sum_s[i] += sum_l[i];
+		if (i < upper) sum_l[i + 1] += sum_s[i];
+	}
+
+	std::vector<int32_t> buf(upper + 1);
+	const auto induce = [&](const std::vector<int32_t>& lms) {
+		std::fill(sa.begin(), sa.end(), -1);
+		std::copy(sum_s.begin(), sum_s.end(), buf.begin());
+		for (const auto d : lms) {
+			if (d == n) continue;
+			sa[buf[s[d]]++] = d;
+		}
+		std::copy(sum_l.begin(), sum_l.end(), buf.begin());
+		sa[buf[s[n - 1]]++] = n - 1;
+		for (int32_t i = 0; i < n; ++i) {
+			const auto v = sa[i];
+			if ((v >= 1) && !ls[v - 1]) sa[buf[s[v - 1]]++] = v - 1;
+		}
+		std::copy(sum_l.begin(), sum_l.end(), buf.begin());
+		for (int32_t i = n - 1; i >= 0; --i) {
+			const auto v = sa[i];
+			if ((v >= 1) && ls[v - 1]) sa[--buf[s[v - 1] + 1]] = v - 1;
+		}
+	};
+
+	//leftmost s-type positions
+	std::vector<int32_t> lms_map(n + 1, -1);
+	std::vector<int32_t> lms;
+	int32_t m = 0;
+	for (int32_t i = 1; i < n; ++i) {
+		if (!ls[i - 1] && ls[i]) lms_map[i] = m++;
+	}
+	lms.reserve(m);
+	for (int32_t i = 1; i < n; ++i) {
+		if (!ls[i - 1] && ls[i]) lms.push_back(i);
+	}
+
+	induce(lms);
+	if (!m || Index.cancel.cancelled()) return sa;
+
+	//name the sorted lms substrings and sort them recursively
+	std::vector<int32_t> sorted_lms;
+	sorted_lms.reserve(m);
+	for (const auto v : sa) {
+		if (lms_map[v] != -1) sorted_lms.push_back(v);
+	}
+
+	std::vector<int32_t> rec_s(m);
+	int32_t rec_upper = 0;
+	rec_s[lms_map[sorted_lms[0]]] = 0;
+	for (int32_t i = 1; i < m; ++i) {
+		auto l = sorted_lms[i - 1];
+		auto r = sorted_lms[i];
+		const auto end_l = (lms_map[l] + 1 < m) ? lms[lms_map[l] + 1] : n;
+		const auto end_r = (lms_map[r] + 1 < m) ? lms[lms_map[r] + 1] : n;
+		bool same = true;
+		if (end_l - l != end_r - r) {
+			same = false;
+		}
+		else {
+			while ((l < end_l) && (s[l] == s[r])) ++l, ++r;
+			if ((l == n) || (s[l] != s[r])) same = false;
+		}
+		if (!same) ++rec_upper;
+		rec_s[lms_map[sorted_lms[i]]] = rec_upper;
+	}
+	lms_map = std::vector<int32_t>{};
+
+	const auto rec_sa = sa_is(rec_s.data(), m, rec_upper);
+	if (Index.cancel.cancelled()) return sa;
+
+	for (int32_t i = 0; i < m; ++i) {
+		sorted_lms[i] = lms[rec_sa[i]];
+	}
+	induce(sorted_lms);
+	return sa;
+}
+
+static uint64_t hash_text(const std::vector<uint8_t>& text) {
+	uint64_t h = 14695981039346656037ULL;
+	size_t i = 0;
+	for (; i + 8 <= text.size(); i += 8) {
+		uint64_t w;
+		memcpy(&w, &text[i], 8);
+		h = (h ^ w) * 1099511628211ULL;
+	}
+	for (; i < text.size(); ++i) h = (h ^ text[i]) * 1099511628211ULL;
+	return h;
+}
+
+static std::string index_path(const ProcessInfo::ExeInfo::VersionInfo& v) {
+	char path[MAX_PATH];
+	snprintf(path, sizeof(path), "analysis_cache/%u.%u.%u.%u.sa", v.major, v.minor, v.build, v.revision);
+	return std::string{ path };
+}
+
+static bool load_index(const char* path, uint64_t text_hash) {
+	FILE* f = NULL;
+	fopen_s(&f, path, "rb");
+	if (!f) return false;
+
+	IndexFileHeader hdr;
+	bool ok = (fread(&hdr, sizeof(hdr), 1, f) == 1);
+	ok = ok && !memcmp(hdr.magic, INDEX_MAGIC, sizeof(hdr.magic)) && (hdr.format == INDEX_FORMAT);
+	ok = ok && (hdr.text_size == Index.text.size()) && (hdr.text_hash == text_hash);
+	if (ok) {
+		Index.sa.resize(hdr.text_size);
+		ok = (fread(Index.sa.data(), sizeof(int32_t), hdr.text_size, f) == hdr.text_size);
+	}
+	fclose(f);
+
+	if (!ok) Index.sa.clear();
+	return ok;
+}
+
+static void save_index(const char* path, uint64_t text_hash, const ProcessInfo::ExeInfo::VersionInfo& version) {
+	CreateDirectoryA("analysis_cache", NULL);
+
+	FILE* f = NULL;
+	fopen_s(&f, path, "wb");
+	if (!f) return;
+
+	IndexFileHeader hdr{};
+	memcpy(hdr.magic, INDEX_MAGIC, sizeof(hdr.magic));
+	hdr.format = INDEX_FORMAT;
+	hdr.text_size = (uint32_t)Index.text.size();
+	hdr.text_hash = text_hash;
+	hdr.version = version;
+	fwrite(&hdr, sizeof(hdr), 1, f);
+	fwrite(Index.sa.data(), sizeof(int32_t), Index.sa.size(), f);
+	fclose(f);
+}
+
+static void build_task(ProcessInfo::ExeInfo::VersionInfo version) {
+	LARGE_INTEGER freq, start, end;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	const auto path = index_path(version);
+	const auto text_hash = hash_text(Index.text);
+
+	Index.from_cache = load_index(path.c_str(), text_hash);
+	if (!Index.from_cache) {
+		Index.sa = sa_is(Index.text.data(), (int32_t)Index.text.size(), 255);
+		if (Index.cancel.cancelled()) {
+			Index.sa.clear();
+			Index.state = TextIndex_None;
+			return;
+		}
+		save_index(path.c_str(), text_hash, version);
+	}
+
+	QueryPerformanceCounter(&end);
+	Index.build_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+	Log("Text index %s in %.0fms (%u bytes of .text)", Index.from_cache ? "loaded" : "built", Index.build_ms, (unsigned)Index.text.size());
+	Index.state = TextIndex_Ready;
+}
+
+extern void text_index_reset(void) {
+	Index.cancel.cancel();
+	task_wait(Index.worker);
+	Index.cancel.reset();
+
+	Index.state = TextIndex_None;
+	Index.text = std::vector<uint8_t>{};
+	Index.sa = std::vector<int32_t>{};
+	Index.build_ms = 0;
+	Index.from_cache = false;
+}
+
+extern void text_index_build_async(void) {
+	text_index_reset();
+
+	const auto& t = GameProcessInfo.exe.text;
+	if (!GameProcessInfo.buffer || !t.size || ((uint64_t)t.offset + t.size > GameProcessInfo.buffer_size) || (t.size > INT32_MAX)) {
+		Index.state = TextIndex_Failed;
+		return;
+	}
+
+	const auto begin = (const uint8_t*)GameProcessInfo.buffer + t.offset;
+	Index.text.assign(begin, begin + t.size);
+	Index.text_offset = t.offset;
+	Index.state = TextIndex_Building;
+	const auto version = GameProcessInfo.exe.version;
+	task_submit([version] { build_task(version); }, &Index.worker, TaskPriority_Background, &Index.cancel);
+}
+
+extern bool text_index_ready(void) {
+	return Index.state == TextIndex_Ready;
+}
+
+extern TextIndexStats text_index_stats(void) {
+	TextIndexStats ret{};
+	ret.state = (TextIndexState)Index.state.load();
+	if (ret.state == TextIndex_Ready) {
+		ret.from_cache = Index.from_cache;
+		ret.build_ms = Index.build_ms;
+		ret.memory = Index.text.size() + Index.sa.size() * sizeof(int32_t);
+	}
+	return ret;
+}
+
+//range of suffixes starting with bytes, as [first, last)
+static void sa_range(const uint8_t* bytes, uint32_t size, size_t* first, size_t* last) {
+	const auto text = Index.text.data();
+	const auto n = Index.text.size();
+
+	//compare the first size bytes of the suffix with the needle, a shorter suffix sorts first
+	const auto cmp = [&](int32_t pos) -> int {
+		const auto avail = n - (size_t)pos;
+		const auto len = (avail < size) ? avail : size;
+		const int c = memcmp(text + pos, bytes, len);
+		if (c) return c;
+		return (len < size) ? -1 : 0;
+	};
+
+	const auto lower = std::partition_point(Index.sa.begin(), Index.sa.end(), [&](int32_t pos) { return cmp(pos) < 0; });
+	const auto upper = std::partition_point(lower, Index.sa.end(), [&](int32_t pos) { return cmp(pos) == 0; });
+	*first = lower - Index.sa.begin();
+	*last = upper - Index.sa.begin();
+}
+
+extern bool text_index_find_exact(const uint8_t* bytes, uint32_t size, std::vector<uint32_t>& results) {
+	if (!text_index_ready() || !size) return false;
+
+	size_t first, last;
+	sa_range(bytes, size, &first, &last);
+	results.clear();
+	results.reserve(last - first);
+	for (auto i = first; i < last; ++i) {
+		results.push_back(Index.text_offset + Index.sa[i]);
+	}
+	return true;
+}
+
+extern bool text_index_find(AOB_SIG sig, std::vector<uint32_t>& results) {
+	if (!text_index_ready()) return false;
+
+	//longest run of fully specified bytes
+	unsigned length = 0, run_start = 0, run_length = 0;
+	for (unsigned i = 0, start = 0; sig[i] != AOB_SIG_END; ++i, ++length) {
+		if ((sig[i] >> 8) != 0xFF) {
+			start = i + 1;
+			continue;
+		}
+		if (i + 1 - start > run_length) {
+			run_start = start;
+			run_length = i + 1 - start;
+		}
+	}
+	if (!run_length) return false;
+
+	std::vector<uint8_t> literal(run_length);
+	for (unsigned i = 0; i < run_length; ++i) literal[i] = (uint8_t)sig[run_start + i];
+
+	size_t first, last;
+	sa_range(literal.data(), run_length, &first, &last);
+
+	const auto text = Index.text.data();
+	const auto n = Index.text.size();
+	results.clear();
+	for (auto i = first; i < last; ++i) {
+		const auto pos = (size_t)Index.sa[i];
+		if (pos < run_start) continue;
+		const auto begin = pos - run_start;
+		if (begin + length > n) continue;
+
+		bool match = true;
+		for (unsigned k = 0; k < length; ++k) {
+			if ((text[begin + k] & (sig[k] >> 8)) != (sig[k] & 0xFF)) {
+				match = false;
+				break;
+			}
+		}
+		if (match) results.push_back(Index.text_offset + (uint32_t)begin);
+	}
+
+	std::sort(results.begin(), results.end());
+	return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "main.h"
+#include "aobscan.h"
+
+//suffix array over the .text section for index backed aob queries
+//built in the background after a scan and cached in analysis_cache/<version>.sa
+//the index holds a private copy of .text, so it stays valid while the process is rescanned
+
+enum TextIndexState : unsigned {
+	TextIndex_None,
+	TextIndex_Building,
+	TextIndex_Ready,
+	TextIndex_Failed,
+};
+
+struct TextIndexStats {
+	TextIndexState state;
+	bool from_cache;
+	double build_ms;
+	uint64_t memory; //bytes held by the index
+};
+
+//start building (or loading) the index for the current .text, replaces any previous index
+extern void text_index_build_async(void);
+
+//stop a running build and release the index
+extern void text_index_reset(void);
+
+extern bool text_index_ready(void);
+extern TextIndexStats text_index_stats(void);
+
+/// offsets (relative to the image base) of every match of a compiled signature, sorted
+/// the longest literal run of the signature is looked up in the suffix array and the candidates are verified
+/// returns false if the index is not ready or the signature has no literal bytes, use aob_scan then
+extern bool text_index_find(AOB_SIG sig, std::vector<uint32_t>& results);
+
+/// offsets of every occurrence of an exact byte string, unsorted, in O(m log n)
+extern bool text_index_find_exact(const uint8_t* bytes, uint32_t size, std::vector<uint32_t>& results);
\ No newline at end of file
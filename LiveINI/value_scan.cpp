@@ -0,0 +1,398 @@
+#include "value_scan.h"
+#include "process.h"
+#include "large_pages.h"
+
+#include <emmintrin.h>
+#include <limits>
+
+
+static constexpr uint32_t SCAN_CHUNK_SIZE = 4 * 1024 * 1024;
+static constexpr uint32_t RESCAN_WINDOW = 64 * 1024; //largest single read when narrowing
+static constexpr uint32_t RESCAN_GAP = 4096;         //addresses further apart than this start a new read
+
+extern uint32_t value_type_size(ValueType type) {
+	switch (type) {
+	case ValueType_Int8: return 1;
+	case ValueType_Int16: return 2;
+	case ValueType_Int32: return 4;
+	case ValueType_Int64: return 8;
+	case ValueType_Float: return 4;
+	case ValueType_Double: return 8;
+	case ValueType_UTF8: return 1;
+	case ValueType_UTF16: return 2;
+	}
+	return 0;
+}
+
+extern std::string value_query_pattern(const ValueQuery& q) {
+	if (q.type != ValueType_UTF16) return q.text;
+
+	const int len = MultiByteToWideChar(CP_UTF8, 0, q.text.c_str(), (int)q.text.size(), NULL, 0);
+	if (len <= 0) return std::string{};
+	std::wstring wide(len, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, q.text.c_str(), (int)q.text.size(), &wide[0], len);
+	return std::string{ (const char*)wide.data(), wide.size() * sizeof(wchar_t) };
+}
+
+
+//range kernels, one specialization per type
+//mask() tests a 16 byte block and returns one bit per lane, test() is the scalar equivalent
+template<typename T> struct RangeKernel;
+
+template<typename T, typename V>
+static bool clamp_bounds(V lo, V hi, T* out_lo, T* out_hi) {
+	const V min = (V)std::numeric_limits<T>::lowest();
+	const V max = (V)std::numeric_limits<T>::max();
+	if ((hi < min) || (lo > max) || (lo > hi)) return false;
+	*out_lo = (T)((lo < min) ? min : lo);
+	*out_hi = (T)((hi > max) ? max : hi);
+	return true;
+}
+
+template<> struct RangeKernel<int8_t> {
+	struct Bounds { __m128i lo, hi; int8_t slo, shi; };
+	static bool bounds(const ValueQuery& q, Bounds* b) {
+		if (!clamp_bounds(q.lo.as_int, q.hi.as_int, &b->slo, &b->shi)) return false;
+		b->lo = _mm_set1_epi8(b->slo);
+		b->hi = _mm_set1_epi8(b->shi);
+		return true;
+	}
+	static unsigned mask(const uint8_t* p, const Bounds& b) {
+		const __m128i x = _mm_loadu_si128((const __m128i*)p);
+		const __m128i out = _mm_or_si128(_mm_cmpgt_epi8(b.lo, x), _mm_cmpgt_epi8(x, b.hi));
+		return ~(unsigned)_mm_movemask_epi8(out) & 0xFFFF;
+	}
+	static bool test(const uint8_t* p, const Bounds& b) {
+		const int8_t x = (int8_t)*p;
+		return (x >= b.slo) && (x <= b.shi);
+	}
+};
+
+template<> struct RangeKernel<int16_t> {
+	struct Bounds { __m128i lo, hi; int16_t slo, shi; };
+	static bool bounds(const ValueQuery& q, Bounds* b) {
+		if (!clamp_bounds(q.lo.as_int, q.hi.as_int, &b->slo, &b->shi)) return false;
+		b->lo = _mm_set1_epi16(b->slo);
+		b->hi = _mm_set1_epi16(b->shi);
+		return true;
+	}
+	static unsigned mask(const uint8_t* p, const Bounds& b) {
+		const __m128i x = _mm_loadu_si128((const __m128i*)p);
+		const __m128i out = _mm_or_si128(_mm_cmpgt_epi16(b.lo, x), _mm_cmpgt_epi16(x, b.hi));
+		return ~(unsigned)_mm_movemask_epi8(_mm_packs_epi16(out, out)) & 0xFF;
+	}
+	static bool test(const uint8_t* p, const Bounds& b) {
+		int16_t x;
+		memcpy(&x, p, sizeof(x));
+		return (x >= b.slo) && (x <= b.shi);
+	}
+};
+
+template<> struct RangeKernel<int32_t> {
+	struct Bounds { __m128i lo, hi; int32_t slo, shi; };
+	static bool bounds(const ValueQuery& q, Bounds* b) {
+		if (!clamp_bounds(q.lo.as_int, q.hi.as_int, &b->slo, &b->shi)) return false;
+		b->lo = _mm_set1_epi32(b->slo);
+		b->hi = _mm_set1_epi32(b->shi);
+		return true;
+	}
+	static unsigned mask(const uint8_t* p, const Bounds& b) {
+		const __m128i x = _mm_loadu_si128((const __m128i*)p);
+		const __m128i out = _mm_or_si128(_mm_cmpgt_epi32(b.lo, x), _mm_cmpgt_epi32(x, b.hi));
+		return ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xF;
+	}
+	static bool test(const uint8_t* p, const Bounds& b) {
+		int32_t x;
+		memcpy(&x, p, sizeof(x));
+		return (x >= b.slo) && (x <= b.shi);
+	}
+};
+
+//sse2 has no 64 bit integer compare
+template<> struct RangeKernel<int64_t> {
+	struct Bounds { int64_t slo, shi; };
+	static bool bounds(const ValueQuery& q, Bounds* b) {
+		if (q.lo.as_int > q.hi.as_int) return false;
+		b->slo = q.lo.as_int;
+		b->shi = q.hi.as_int;
+		return true;
+	}
+	static unsigned mask(const uint8_t* p, const Bounds& b) {
+		return (unsigned)test(p, b) | ((unsigned)test(p + 8, b) << 1);
+	}
+	static bool test(const uint8_t* p, const Bounds& b) {
+		int64_t x;
+		memcpy(&x, p, sizeof(x));
+		return (x >= b.slo) && (x <= b.shi);
+	}
+};
+
+template<> struct RangeKernel<float> {
+	struct Bounds { __m128 lo, hi; float slo, shi; };
+	static bool bounds(const ValueQuery& q, Bounds* b) {
+		if (!clamp_bounds(q.lo.as_float, q.hi.as_float, &b->slo, &b->shi)) return false;
+		b->lo = _mm_set1_ps(b->slo);
+		b->hi = _mm_set1_ps(b->shi);
+		return true;
+	}
+	static unsigned mask(const uint8_t* p, const Bounds& b) {
+		const __m128 x = _mm_loadu_ps((const float*)p);
+		return (unsigned)_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(x, b.lo), _mm_cmple_ps(x, b.hi)));
+	}
+	static bool test(const uint8_t* p, const Bounds& b) {
+		float x;
+		memcpy(&x, p, sizeof(x));
+		return (x >= b.slo) && (x <= b.shi);
+	}
+};
+
+template<> struct RangeKernel<double> {
+	struct Bounds { __m128d lo, hi; double slo, shi; };
+	static bool bounds(const ValueQuery& q, Bounds* b) {
+		if (!(q.lo.as_float <= q.hi.as_float)) return false;
+		b->slo = q.lo.as_float;
+		b->shi = q.hi.as_float;
+		b->lo = _mm_set1_pd(b->slo);
+		b->hi = _mm_set1_pd(b->shi);
+		return true;
+	}
+	static unsigned mask(const uint8_t* p, const Bounds& b) {
+		const __m128d x = _mm_loadu_pd((const double*)p);
+		return (unsigned)_mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(x, b.lo), _mm_cmple_pd(x, b.hi)));
+	}
+	static bool test(const uint8_t* p, const Bounds& b) {
+		double x;
+		memcpy(&x, p, sizeof(x));
+		return (x >= b.slo) && (x <= b.shi);
+	}
+};
+
+
+struct ScanOutput {
+	std::vector<uintptr_t>* results;
+	uint64_t count;
+
+	void emit(uintptr_t address) {
+		++count;
+		if (results->size() < VALUE_MAX_RESULTS) results->push_back(address);
+	}
+};
+
+/// scan buf for values of type T, only offsets below report_limit are reported
+/// unaligned scans run the aligned kernel once per byte phase
+template<typename T>
+static void scan_values(const uint8_t* buf, uint32_t size, uint32_t report_limit, uintptr_t address, const typename RangeKernel<T>::Bounds& b, bool aligned, ScanOutput& out) {
+	typedef RangeKernel<T> K;
+	const uint32_t n = sizeof(T);
+	const uint32_t phases = (aligned) ? 1 : n;
+	const auto first_result = out.results->size();
+
+	for (uint32_t phase = 0; phase < phases; ++phase) {
+		uint32_t i = phase;
+		for (; i + 16 <= size; i += 16) {
+			unsigned m = K::mask(buf + i, b);
+			while (m) {
+				unsigned long bit;
+				_BitScanForward(&bit, m);
+				m &= m - 1;
+				const uint32_t offset = i + (bit * n);
+				if (offset < report_limit) out.emit(address + offset);
+			}
+		}
+		for (; i + n <= size; i += n) {
+			if ((i < report_limit) && K::test(buf + i, b)) out.emit(address + i);
+		}
+	}
+
+	if (phases > 1) {
+		std::sort(out.results->begin() + first_result, out.results->end());
+	}
+}
+
+//candidates are filtered on the first and last byte of the pattern 16 positions at a time
+static void scan_pattern(const uint8_t* buf, uint32_t size, uint32_t report_limit, uintptr_t address, const std::string& pattern, uint32_t step, ScanOutput& out) {
+	const auto len = (uint32_t)pattern.size();
+	const auto pat = (const uint8_t*)pattern.data();
+	if (!len || (len > size)) return;
+
+	const __m128i first = _mm_set1_epi8((char)pat[0]);
+	const __m128i last = _mm_set1_epi8((char)pat[len - 1]);
+
+	const auto check = [&](uint32_t pos) {
+		if (pos >= report_limit) return;
+		if ((step > 1) && ((address + pos) % step)) return;
+		if (memcmp(buf + pos, pat, len)) return;
+		out.emit(address + pos);
+	};
+
+	uint32_t i = 0;
+	for (; i + (len - 1) + 16 <= size; i += 16) {
+		const __m128i a = _mm_loadu_si128((const __m128i*)(buf + i));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(buf + i + len - 1));
+		unsigned m = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+		while (m) {
+			unsigned long bit;
+			_BitScanForward(&bit, m);
+			m &= m - 1;
+			check(i + bit);
+		}
+	}
+	for (; i + len <= size; ++i) {
+		check(i);
+	}
+}
+
+//one read buffer for every value type, on large pages when available (locked memory), released by value_scan_release
+static uint8_t* ScanBuffer = NULL;
+//rescans read smaller windows, their buffer is ordinary memory
+static uint8_t* ReadBuffer = NULL;
+
+static uint8_t* scan_buffer(void) {
+	if (!ScanBuffer) {
+		ScanBuffer = (uint8_t*)large_alloc(SCAN_CHUNK_SIZE * 2);
+		if (!ScanBuffer) Log("Value scan: could not allocate the %uMB read buffer", (SCAN_CHUNK_SIZE * 2) / (1024 * 1024));
+	}
+	return ScanBuffer;
+}
+
+extern void value_scan_release(void) {
+	if (ScanBuffer) large_free(ScanBuffer);
+	if (ReadBuffer) _aligned_free(ReadBuffer);
+	ScanBuffer = NULL;
+	ReadBuffer = NULL;
+}
+
+template<typename T>
+static uint64_t scan_regions(const std::vector<MemoryBlock>& regions, const ValueQuery& q, std::vector<uintptr_t>& results) {
+	typename RangeKernel<T>::Bounds b;
+	if (!RangeKernel<T>::bounds(q, &b)) return 0;
+
+	const auto buffer = scan_buffer();
+	if (!buffer) return 0;
+
+	ScanOutput out{ &results, 0 };
+	const uint32_t overlap = (q.aligned) ? 0 : (sizeof(T) - 1);
+
+	for (const auto& r : regions) {
+		for (uint64_t offset = 0; offset < r.size; offset += SCAN_CHUNK_SIZE) {
+			const uint64_t remain = r.size - offset;
+			const auto report = (uint32_t)((remain > SCAN_CHUNK_SIZE) ? SCAN_CHUNK_SIZE : remain);
+			const auto size = (uint32_t)((remain > (uint64_t)report + overlap) ? (report + overlap) : remain);
+			if (!RPM(r.address + offset, buffer, size)) continue;
+			scan_values<T>(buffer, size, report, r.address + offset, b, q.aligned, out);
+		}
+	}
+
+	return out.count;
+}
+
+static uint64_t scan_strings(const std::vector<MemoryBlock>& regions, const ValueQuery& q, std::vector<uintptr_t>& results) {
+	const auto pattern = value_query_pattern(q);
+	if (pattern.empty() || (pattern.size() > SCAN_CHUNK_SIZE)) return 0;
+
+	const auto buffer = scan_buffer();
+	if (!buffer) return 0;
+
+	ScanOutput out{ &results, 0 };
+	const auto overlap = (uint32_t)pattern.size() - 1;
+	const uint32_t step = (q.aligned) ? value_type_size(q.type) : 1;
+
+	for (const auto& r : regions) {
+		for (uint64_t offset = 0; offset < r.size; offset += SCAN_CHUNK_SIZE) {
+			const uint64_t remain = r.size - offset;
+			const auto report = (uint32_t)((remain > SCAN_CHUNK_SIZE) ? SCAN_CHUNK_SIZE : remain);
+			const auto size = (uint32_t)((remain > (uint64_t)report + overlap) ? (report + overlap) : remain);
+			if (!RPM(r.address + offset, buffer, size)) continue;
+			scan_pattern(buffer, size, report, r.address + offset, pattern, step, out);
+		}
+	}
+
+	return out.count;
+}
+
+extern uint64_t value_scan(const std::vector<MemoryBlock>& regions, const ValueQuery& q, std::vector<uintptr_t>& results) {
+	results.clear();
+
+	auto sorted = regions;
+	std::sort(sorted.begin(), sorted.end(), [](const MemoryBlock& a, const MemoryBlock& b) { return a.address < b.address; });
+
+	switch (q.type) {
+	case ValueType_Int8: return scan_regions<int8_t>(sorted, q, results);
+	case ValueType_Int16: return scan_regions<int16_t>(sorted, q, results);
+	case ValueType_Int32: return scan_regions<int32_t>(sorted, q, results);
+	case ValueType_Int64: return scan_regions<int64_t>(sorted, q, results);
+	case ValueType_Float: return scan_regions<float>(sorted, q, results);
+	case ValueType_Double: return scan_regions<double>(sorted, q, results);
+	case ValueType_UTF8:
+	case ValueType_UTF16: return scan_strings(sorted, q, results);
+	}
+	return 0;
+}
+
+
+//narrowing reads every run of nearby previous hits with a single RPM and tests each hit in place
+template<typename Match>
+static uint64_t rescan(std::vector<uintptr_t>& results, uint32_t value_size, Match match) {
+	if (!ReadBuffer) {
+		ReadBuffer = (uint8_t*)_aligned_malloc(RESCAN_WINDOW + 4096, 4096);
+		if (!ReadBuffer) {
+			Log("Value scan: could not allocate the rescan buffer");
+			results.clear();
+			return 0;
+		}
+	}
+
+	std::vector<uintptr_t> kept;
+	kept.reserve(results.size());
+
+	const auto count = results.size();
+	size_t i = 0;
+	while (i < count) {
+		const uintptr_t start = results[i];
+		size_t j = i + 1;
+		while ((j < count) && (results[j] + value_size - start <= RESCAN_WINDOW) && (results[j] - results[j - 1] <= RESCAN_GAP)) ++j;
+
+		const auto read_size = (uint32_t)(results[j - 1] + value_size - start);
+		if (RPM(start, ReadBuffer, read_size)) {
+			for (size_t k = i; k < j; ++k) {
+				if (match(ReadBuffer + (results[k] - start))) kept.push_back(results[k]);
+			}
+		}
+
+		i = j;
+	}
+
+	results.swap(kept);
+	return results.size();
+}
+
+template<typename T>
+static uint64_t rescan_values(const ValueQuery& q, std::vector<uintptr_t>& results) {
+	typename RangeKernel<T>::Bounds b;
+	if (!RangeKernel<T>::bounds(q, &b)) {
+		results.clear();
+		return 0;
+	}
+	return rescan(results, sizeof(T), [&b](const uint8_t* p) { return RangeKernel<T>::test(p, b); });
+}
+
+extern uint64_t value_rescan(const ValueQuery& q, std::vector<uintptr_t>& results) {
+	switch (q.type) {
+	case ValueType_Int8: return rescan_values<int8_t>(q, results);
+	case ValueType_Int16: return rescan_values<int16_t>(q, results);
+	case ValueType_Int32: return rescan_values<int32_t>(q, results);
+	case ValueType_Int64: return rescan_values<int64_t>(q, results);
+	case ValueType_Float: return rescan_values<float>(q, results);
+	case ValueType_Double: return rescan_values<double>(q, results);
+	case ValueType_UTF8:
+	case ValueType_UTF16: {
+		const auto pattern = value_query_pattern(q);
+		if (pattern.empty() || (pattern.size() > RESCAN_WINDOW)) {
+			results.clear();
+			return 0;
+		}
+		return rescan(results, (uint32_t)pattern.size(), [&pattern](const uint8_t* p) { return !memcmp(p, pattern.data(), pattern.size()); });
+	}
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "main.h"
+
+constexpr uint32_t VALUE_MAX_RESULTS = 8 * 1024 * 1024;
+
+enum ValueType : unsigned {
+	ValueType_Int8,
+	ValueType_Int16,
+	ValueType_Int32,
+	ValueType_Int64,
+	ValueType_Float,
+	ValueType_Double,
+	ValueType_UTF8,
+	ValueType_UTF16,
+};
+
+//every numeric search is a closed range, exact integer searches use lo == hi
+//and exact float searches use [value - epsilon, value + epsilon]
+struct ValueQuery {
+	ValueType type;
+	bool aligned; //only consider addresses that are a multiple of the value size
+	union {
+		int64_t as_int;
+		double  as_float;
+	} lo, hi;
+	std::string text; //utf-8 search text for the string types
+};
+
+extern uint32_t value_type_size(ValueType type);
+
+//the bytes that are actually searched for by the string types
+extern std::string value_query_pattern(const ValueQuery& q);
+
+/// scan the given regions of the game process for values matching the query
+/// up to VALUE_MAX_RESULTS sorted addresses are stored in results, returns the total match count
+extern uint64_t value_scan(const std::vector<MemoryBlock>& regions, const ValueQuery& q, std::vector<uintptr_t>& results);
+
+/// re-evaluate only the (sorted) addresses in results against a new query
+/// nearby addresses are coalesced so each block of memory is read once, returns the remaining count
+extern uint64_t value_rescan(const ValueQuery& q, std::vector<uintptr_t>& results);
+
+//free the read buffers, e.g. when the value tab is closed or the process detached, the next scan allocates them again
+extern void value_scan_release(void);
\ No newline at end of file
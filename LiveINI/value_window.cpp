@@ -0,0 +1,190 @@
+#include "main.h"
+#include "value_window.h"
+#include "value_scan.h"
+#include "process.h"
+
+#include <cmath>
+
+static std::vector<uintptr_t> Results{};
+static uint64_t ResultCount = 0;
+static ValueQuery LastQuery{};
+
+static bool is_float_type(int type) {
+        return (type == ValueType_Float) || (type == ValueType_Double);
+}
+
+static bool is_string_type(int type) {
+        return (type == ValueType_UTF8) || (type == ValueType_UTF16);
+}
+
+static void format_value(char* out, size_t out_size, uintptr_t address, const ValueQuery& q) {
+        uint8_t buffer[256] = {};
+        const auto size = (is_string_type(q.type)) ? (uint32_t)value_query_pattern(q).size() : value_type_size(q.type);
+
+        if ((size > sizeof(buffer) - 2) || !RPM(address, buffer, size)) {
+                snprintf(out, out_size, "??");
+                return;
+        }
+
+        switch (q.type) {
+        case ValueType_Int8: snprintf(out, out_size, "%d", (int)(int8_t)buffer[0]); break;
+        case ValueType_Int16: { int16_t v; memcpy(&v, buffer, sizeof(v)); snprintf(out, out_size, "%d", (int)v); } break;
+        case ValueType_Int32: { int32_t v; memcpy(&v, buffer, sizeof(v)); snprintf(out, out_size, "%d", v); } break;
+        case ValueType_Int64: { int64_t v; memcpy(&v, buffer, sizeof(v)); snprintf(out, out_size, "%lld", v); } break;
+        case ValueType_Float: { float v; memcpy(&v, buffer, sizeof(v)); snprintf(out, out_size, "%g", v); } break;
+        case ValueType_Double: { double v; memcpy(&v, buffer, sizeof(v)); snprintf(out, out_size, "%g", v); } break;
+        case ValueType_UTF8: snprintf(out, out_size, "\"%s\"", (const char*)buffer); break;
+        case ValueType_UTF16: {
+                char narrow[128];
+                unsigned i = 0;
+                for (; (i < (size / 2)) && (i < sizeof(narrow) - 1); ++i) {
+                        narrow[i] = (buffer[i * 2 + 1]) ? '?' : (char)buffer[i * 2];
+                }
+                narrow[i] = '\0';
+                snprintf(out, out_size, "L\"%s\"", narrow);
+        } break;
+        }
+}
+
+static bool build_query(ValueQuery& q, int type, int mode, const char* value, const char* value_to, const char* epsilon, bool aligned) {
+        q.type = (ValueType)type;
+        q.aligned = aligned;
+        q.text.clear();
+
+        if (is_string_type(type)) {
+                q.text = value;
+                return !q.text.empty();
+        }
+
+        if (!*value) return false;
+
+        if (is_float_type(type)) {
+                const double v = strtod(value, NULL);
+                if (mode == 0) {
+                        const double e = fabs(strtod(epsilon, NULL));
+                        q.lo.as_float = v - e;
+                        q.hi.as_float = v + e;
+                }
+                else {
+                        q.lo.as_float = v;
+                        q.hi.as_float = strtod(value_to, NULL);
+                }
+        }
+        else {
+                const int64_t v = strtoll(value, NULL, 0);
+                q.lo.as_int = v;
+                q.hi.as_int = (mode == 0) ? v : strtoll(value_to, NULL, 0);
+        }
+        return true;
+}
+
+extern void draw_value_window() {
+        static int type = ValueType_Int32;
+        static int mode = 0;
+        static char value[128];
+        static char value_to[64];
+        static char epsilon[32] = "0.001";
+        static bool aligned = true;
+        static bool writable_only = true;
+        static bool resident_only = true;
+        static int min_region_kb = 64;
+        static uint64_t last_scan_ms = 0;
+        static ResidencyStats residency{};
+
+        if (!GameProcessInfo.rtti_map.size()) {
+                ImGui::Text("Press Scan Starfield in the log window");
+                return;
+        }
+
+        ImGui::SetNextItemWidth(120.f);
+        ImGui::Combo("Type", &type, "Int8\0Int16\0Int32\0Int64\0Float\0Double\0UTF-8\0UTF-16\0");
+        if (!is_string_type(type)) {
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120.f);
+                ImGui::Combo("Mode", &mode, "Exact\0Range\0");
+        }
+
+        ImGui::SetNextItemWidth(200.f);
+        ImGui::InputText((is_string_type(type) || (mode == 0)) ? "Value" : "From", value, sizeof(value));
+        if (!is_string_type(type)) {
+                if (mode == 1) {
+                        ImGui::SameLine();
+                        ImGui::SetNextItemWidth(120.f);
+                        ImGui::InputText("To", value_to, sizeof(value_to));
+                }
+                else if (is_float_type(type)) {
+                        ImGui::SameLine();
+                        ImGui::SetNextItemWidth(120.f);
+                        ImGui::InputText("Epsilon", epsilon, sizeof(epsilon));
+                }
+        }
+
+        ImGui::Checkbox("Aligned", &aligned);
+        ImGui::SameLine();
+        ImGui::Checkbox("Writable regions only", &writable_only);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120.f);
+        ImGui::InputInt("Min region KB", &min_region_kb);
+        if (min_region_kb < 4) min_region_kb = 4;
+        ImGui::SameLine();
+        ImGui::Checkbox("Resident pages only", &resident_only);
+
+        LARGE_INTEGER freq, start, end;
+        QueryPerformanceFrequency(&freq);
+
+        if (ImGui::Button("First Scan")) {
+                ValueQuery q{};
+                if (build_query(q, type, mode, value, value_to, epsilon, aligned)) {
+                        QueryPerformanceCounter(&start);
+                        //pages outside the game's working set are skipped unless asked for, reading them would fault them back in
+                        auto regions = GetScanRegions(writable_only, (uint64_t)min_region_kb * 1024);
+                        residency = ResidencyStats{};
+                        if (resident_only) regions = GetResidentRuns(regions, &residency);
+                        ResultCount = value_scan(regions, q, Results);
+                        QueryPerformanceCounter(&end);
+                        last_scan_ms = (uint64_t)((end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart);
+                        LastQuery = q;
+                        Log("Value scan: %llu matches in %u runs, %llu pages skipped, %llums", ResultCount, (unsigned)regions.size(), residency.skipped_pages, last_scan_ms);
+                }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Next Scan") && !Results.empty()) {
+                ValueQuery q{};
+                if (build_query(q, type, mode, value, value_to, epsilon, aligned)) {
+                        QueryPerformanceCounter(&start);
+                        ResultCount = value_rescan(q, Results);
+                        QueryPerformanceCounter(&end);
+                        last_scan_ms = (uint64_t)((end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart);
+                        LastQuery = q;
+                        Log("Value rescan: %llu matches, %llums", ResultCount, last_scan_ms);
+                }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset")) {
+                Results.clear();
+                Results.shrink_to_fit();
+                ResultCount = 0;
+        }
+
+        ImGui::Text("%llu matches (%u listed), %llums", ResultCount, (unsigned)Results.size(), last_scan_ms);
+        if (residency.skipped_pages) {
+                ImGui::SameLine();
+                ImGui::Text("- skipped %llu of %llu pages (paged out or never touched)", residency.skipped_pages, residency.resident_pages + residency.skipped_pages);
+        }
+
+        ImGui::BeginChild("value_results");
+        ImGuiListClipper clip;
+        clip.Begin((int)Results.size(), ImGui::GetTextLineHeightWithSpacing());
+        while (clip.Step()) {
+                for (auto i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
+                        char current[160];
+                        char text[192];
+                        format_value(current, sizeof(current), Results[i], LastQuery);
+                        snprintf(text, sizeof(text), "%p: %s", (void*)Results[i], current);
+                        ImGui::PushID(i);
+                        ImGui::InputText("Address", text, sizeof(text), ImGuiInputTextFlags_ReadOnly);
+                        ImGui::PopID();
+                }
+        }
+        ImGui::EndChild();
+}
\ No newline at end of file
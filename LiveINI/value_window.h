@@ -0,0 +1,3 @@
+#pragma once
+
+extern void draw_value_window();
\ No newline at end of file
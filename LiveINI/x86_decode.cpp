@@ -0,0 +1,164 @@
+#include "x86_decode.h"
+
+#include <cstring>
+
+//one character per opcode, 16 per row
+//  .  no operands      m  modrm           x  invalid in 64-bit mode
+//  b  imm8             B  modrm + imm8    w  imm16
+//  z  imm16/32         Z  modrm + imm16/32
+//  v  imm16/32/64 (mov r, imm)            o  moffs (address sized)
+//  r  rel8             R  rel16/32        e  imm16 + imm8 (enter)
+//  s  group 3 byte     t  group 3 word    (test has an immediate, the rest of the group does not)
+//  p  prefix           V  vex/evex        E  three byte escape
+static const char map_1byte[] =
+	"mmmmbzxxmmmmbzx." //00
+	"mmmmbzxxmmmmbzxx" //10
+	"mmmmbzpxmmmmbzpx" //20
+	"mmmmbzpxmmmmbzpx" //30
+	"pppppppppppppppp" //40 rex
+	"................" //50
+	"xxVmppppzZbB...." //60
+	"rrrrrrrrrrrrrrrr" //70
+	"BZxBmmmmmmmmmmmm" //80
+	"..........x....." //90
+	"oooo....bz......" //A0
+	"bbbbbbbbvvvvvvvv" //B0
+	"BBw.VVBZe.w..bx." //C0
+	"mmmmxxx.mmmmmmmm" //D0
+	"rrrrbbbbRRxr...." //E0
+	"p.pp..st......mm";//F0
+
+static const char map_0f[] =
+	"mmmmx.....x.xm.B" //00
+	"mmmmmmmmmmmmmmmm" //10
+	"mmmmxxxxmmmmmmmm" //20
+	"......x.ExExxxxx" //30
+	"mmmmmmmmmmmmmmmm" //40
+	"mmmmmmmmmmmmmmmm" //50
+	"mmmmmmmmmmmmmmmm" //60
+	"BBBBmmm.mmxxmmmm" //70
+	"RRRRRRRRRRRRRRRR" //80
+	"mmmmmmmmmmmmmmmm" //90
+	"...mBmxx...mBmmm" //A0
+	"mmmmmmmmmmBmmmmm" //B0
+	"mmBmBBBm........" //C0
+	"mmmmmmmmmmmmmmmm" //D0
+	"mmmmmmmmmmmmmmmm" //E0
+	"mmmmmmmmmmmmmmmm";//F0
+
+static_assert(sizeof(map_1byte) == 257, "one byte opcode map must have 256 entries");
+static_assert(sizeof(map_0f) == 257, "0f opcode map must have 256 entries");
+
+extern bool x86_decode(const uint8_t* code, size_t avail, X86Insn* out) {
+	memset(out, 0, sizeof(*out));
+	if (avail > 15) avail = 15;
+
+	size_t i = 0;
+	bool opsize = false;  //66
+	bool addrsize = false; //67
+	bool rex_w = false;
+
+	//legacy prefixes, then an optional rex directly before the opcode
+	for (; i < avail; ++i) {
+		const auto b = code[i];
+		if ((b >= 0x40) && (b <= 0x4F)) {
+			rex_w = !!(b & 8);
+			continue;
+		}
+		if (map_1byte[b] != 'p') break;
+		rex_w = false; //rex must be the last prefix
+		if (b == 0x66) opsize = true;
+		if (b == 0x67) addrsize = true;
+	}
+	if (i >= avail) return false;
+
+	out->opcode_offset = (uint8_t)i;
+	char kind;
+	uint8_t op = code[i++];
+
+	if ((op == 0xC4) || (op == 0xC5) || (op == 0x62)) {
+		//vex/evex, the opcode map comes from the prefix and every instruction has a modrm except vzeroupper/vzeroall
+		const size_t prefix_size = (op == 0xC5) ? 1 : (op == 0xC4) ? 2 : 3;
+		if (i + prefix_size >= avail) return false;
+		const unsigned map = (op == 0xC5) ? 1 : (code[i] & 0x07);
+		if (op != 0x62) rex_w = (op == 0xC4) && (code[i + 1] & 0x80);
+		i += prefix_size;
+		op = code[i++];
+		if (map == 1) kind = map_0f[op];
+		else if (map == 2) kind = 'm';
+		else if (map == 3) kind = 'B';
+		else return false;
+		if (kind == 'x' || kind == 'E' || kind == 'R') kind = 'm';
+	}
+	else if (op == 0x0F) {
+		if (i >= avail) return false;
+		op = code[i++];
+		kind = map_0f[op];
+		if (kind == 'E') {
+			if (i >= avail) return false;
+			kind = (op == 0x38) ? 'm' : 'B';
+			op = code[i++];
+		}
+	}
+	else {
+		kind = map_1byte[op];
+	}
+
+	if (kind == 'x' || kind == 'p' || kind == 'V' || kind == 'E') return false;
+
+	const bool has_modrm = (kind == 'm') || (kind == 'B') || (kind == 'Z') || (kind == 's') || (kind == 't');
+	if (has_modrm) {
+		if (i >= avail) return false;
+		const uint8_t modrm = code[i++];
+		const unsigned mod = modrm >> 6;
+		const unsigned reg = (modrm >> 3) & 7;
+		const unsigned rm = modrm & 7;
+
+		if (mod != 3) {
+			unsigned disp = (mod == 1) ? 1 : (mod == 2) ? 4 : 0;
+			if (rm == 4) {
+				if (i >= avail) return false;
+				const uint8_t sib = code[i++];
+				if ((mod == 0) && ((sib & 7) == 5)) disp = 4;
+			}
+			else if ((mod == 0) && (rm == 5)) {
+				disp = 4;
+				out->rip_relative = true;
+			}
+			if (disp) {
+				out->disp_offset = (uint8_t)i;
+				out->disp_size = (uint8_t)disp;
+				i += disp;
+			}
+		}
+
+		//test r/m, imm is the only member of group 3 with an immediate
+		if (kind == 's') kind = (reg < 2) ? 'b' : '.';
+		else if (kind == 't') kind = (reg < 2) ? 'z' : '.';
+		else if (kind == 'B') kind = 'b';
+		else if (kind == 'Z') kind = 'z';
+		else kind = '.';
+	}
+
+	unsigned imm = 0;
+	switch (kind) {
+	case 'b': imm = 1; break;
+	case 'w': imm = 2; break;
+	case 'e': imm = 3; break;
+	case 'z': imm = opsize ? 2 : 4; break;
+	case 'v': imm = rex_w ? 8 : (opsize ? 2 : 4); break;
+	case 'o': imm = addrsize ? 4 : 8; break;
+	case 'r': imm = 1; out->branch = true; break;
+	case 'R': imm = 4; out->branch = true; break;
+	default: break;
+	}
+	if (imm) {
+		out->imm_offset = (uint8_t)i;
+		out->imm_size = (uint8_t)imm;
+		i += imm;
+	}
+
+	if (i > avail) return false;
+	out->length = (uint8_t)i;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//length decoder for x86-64 code, enough to split a byte stream into instructions
+//and locate the operand bytes that change when code or data moves between builds
+
+struct X86Insn {
+	uint8_t length;
+	uint8_t opcode_offset;
+	uint8_t disp_offset; //0 if the instruction has no displacement
+	uint8_t disp_size;
+	uint8_t imm_offset;  //0 if the instruction has no immediate
+	uint8_t imm_size;
+	bool rip_relative;   //the displacement is relative to the next instruction
+	bool branch;         //the immediate is a relative branch target
+};
+
+//returns false for invalid or truncated instructions
+extern bool x86_decode(const uint8_t* code, size_t avail, X86Insn* out);
\ No newline at end of file